@@ -0,0 +1,127 @@
+#include "aggregates.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    // Rebuild a group's heaps once at least this many removals are pending
+    // and they outnumber the live values
+    const size_t MIN_REMOVED_FOR_COMPACTION = 64;
+    
+    // A sketch is stale once removals reach 1 / this of its group
+    const size_t SKETCH_STALE_DIVISOR = 100;
+}
+
+void GroupAggregates::add(uint32_t group, double salary) {
+    if (group >= groups_.size()) {
+        groups_.resize(group + 1);
+    }
+
+    Group& g = groups_[group];
+    g.count++;
+    g.total += salary;
+    g.maxHeap.push(salary);
+    g.minHeap.push(salary);
+    g.sketch.add(salary);
+}
+
+void GroupAggregates::remove(uint32_t group, double salary) {
+    if (group >= groups_.size() || groups_[group].count == 0) {
+        return;
+    }
+
+    Group& g = groups_[group];
+    if (--g.count == 0) {
+        // Start the group afresh rather than carry rounding left in the sum
+        g = Group();
+        return;
+    }
+
+    g.total -= salary;
+    g.sketchRemovals++;
+    g.maxRemoved.push(salary);
+    g.minRemoved.push(salary);
+    prune(g);
+
+    if (g.maxRemoved.size() >= MIN_REMOVED_FOR_COMPACTION && g.maxRemoved.size() > g.count) {
+        compact(g);
+    }
+}
+
+std::vector<GroupStats> GroupAggregates::stats(const Dictionary& dictionary) const {
+    std::vector<GroupStats> result;
+    for (size_t code = 0; code < groups_.size(); ++code) {
+        const Group& g = groups_[code];
+        if (g.count > 0) {
+            result.push_back({dictionary.decode(static_cast<uint32_t>(code)), g.count, g.total,
+                              g.minHeap.top(), g.maxHeap.top(),
+                              g.sketch.quantile(0.5), g.sketch.quantile(0.9)});
+        }
+    }
+
+    std::sort(result.begin(), result.end(),
+              [](const GroupStats& a, const GroupStats& b) { return a.key < b.key; });
+    return result;
+}
+
+bool GroupAggregates::sketchesStale() const {
+    for (const Group& g : groups_) {
+        if (g.sketchRemovals > 0 && g.sketchRemovals * SKETCH_STALE_DIVISOR >= g.count) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<uint32_t> GroupAggregates::staleGroups() const {
+    std::vector<uint32_t> stale;
+    for (size_t code = 0; code < groups_.size(); ++code) {
+        const Group& g = groups_[code];
+        if (g.sketchRemovals > 0 && g.sketchRemovals * SKETCH_STALE_DIVISOR >= g.count) {
+            stale.push_back(static_cast<uint32_t>(code));
+        }
+    }
+    return stale;
+}
+
+void GroupAggregates::setSketch(uint32_t group, QuantileSketch& sketch) {
+    if (group >= groups_.size()) {
+        return;
+    }
+    groups_[group].sketch = std::move(sketch);
+    groups_[group].sketchRemovals = 0;
+}
+
+void GroupAggregates::prune(Group& group) {
+    // A removed value at the top of its heap is dropped from both
+    while (!group.maxRemoved.empty() && group.maxHeap.top() == group.maxRemoved.top()) {
+        group.maxHeap.pop();
+        group.maxRemoved.pop();
+    }
+    while (!group.minRemoved.empty() && group.minHeap.top() == group.minRemoved.top()) {
+        group.minHeap.pop();
+        group.minRemoved.pop();
+    }
+}
+
+void GroupAggregates::compact(Group& group) {
+    std::vector<double> live;
+    live.reserve(group.maxHeap.size());
+    for (; !group.maxHeap.empty(); group.maxHeap.pop()) {
+        live.push_back(group.maxHeap.top());
+    }
+
+    std::vector<double> removed;
+    removed.reserve(group.maxRemoved.size());
+    for (; !group.maxRemoved.empty(); group.maxRemoved.pop()) {
+        removed.push_back(group.maxRemoved.top());
+    }
+
+    // Both came off a max-heap, so both are in descending order
+    std::vector<double> remaining;
+    std::set_difference(live.begin(), live.end(), removed.begin(), removed.end(),
+                        std::back_inserter(remaining), std::greater<double>());
+
+    group.maxHeap = MaxHeap(std::less<double>(), remaining);
+    group.minHeap = MinHeap(std::greater<double>(), std::move(remaining));
+    group.minRemoved = MinHeap();
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "column_store.h"
+#include <vector>
+#include <queue>
+#include <functional>
+#include <cstdint>
+
+// Running salary aggregates per dictionary-coded group (department or
+// position), kept current by the same insert/remove hooks as the indexes,
+// so a dashboard read is O(groups) instead of a scan.
+//
+// Min and max come from lazy-deletion heaps: a removed salary is pushed
+// onto a matching "removed" heap and both are popped together once it
+// reaches the top. The heaps are rebuilt when removals pile up.
+//
+// Median and p90 come from a QuantileSketch per group. Sketches cannot
+// forget a value, so removals are only counted; once they reach 1% of a
+// group the owner rebuilds that group's sketch from its rows, which costs
+// the group's size rather than a table scan. Removed values still in a
+// sketch add at most that 1% to its rank error.
+class GroupAggregates {
+public:
+    void add(uint32_t group, double salary);
+    void remove(uint32_t group, double salary);
+    void clear() { groups_.clear(); }
+
+    bool sketchesStale() const;
+    // Codes of the groups whose sketch needs rebuilding
+    std::vector<uint32_t> staleGroups() const;
+    void setSketch(uint32_t group, QuantileSketch& sketch);
+
+    // Non-empty groups, named through dictionary and sorted by key
+    std::vector<GroupStats> stats(const Dictionary& dictionary) const;
+
+private:
+    typedef std::priority_queue<double> MaxHeap;
+    typedef std::priority_queue<double, std::vector<double>, std::greater<double>> MinHeap;
+
+    struct Group {
+        size_t count = 0;
+        double total = 0.0;
+        MaxHeap maxHeap;
+        MaxHeap maxRemoved;
+        MinHeap minHeap;
+        MinHeap minRemoved;
+        QuantileSketch sketch;
+        size_t sketchRemovals = 0;   // removed since the sketch was built
+    };
+
+    std::vector<Group> groups_;   // indexed by dictionary code
+
+    static void prune(Group& group);
+    static void compact(Group& group);
+};
@@ -1,4 +1,6 @@
 #include "auth.h"
+#include "mapped_file.h"
+#include "json_loader.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -176,44 +178,26 @@ long long AuthManager::getCurrentTimestamp() {
 }
 
 bool AuthManager::loadUsers() {
-    std::ifstream file(usersFilePath_);
-    if (!file.is_open()) {
+    MappedFile file;
+    if (!file.open(usersFilePath_)) {
         return true; // File doesn't exist, start with empty users
     }
     
-    std::string content((std::istreambuf_iterator<char>(file)),
-                       std::istreambuf_iterator<char>());
-    file.close();
-    
-    if (content.empty() || content == "[]") {
-        return true;
-    }
+    auto started = std::chrono::steady_clock::now();
     
-    // Simple JSON array parsing
-    if (content.front() == '[') content.erase(0, 1);
-    if (content.back() == ']') content.pop_back();
+    std::vector<User> users = JsonArrayLoader::parse<User>(
+        file.data(), file.size(),
+        [](const std::string& json) { return User::fromJson(json); },
+        "user");
     
-    std::string currentObject;
-    int braceCount = 0;
+    for (auto& user : users) {
+        users_[user.username] = user;
+    }
     
-    for (char c : content) {
-        currentObject += c;
-        
-        if (c == '{') {
-            braceCount++;
-        } else if (c == '}') {
-            braceCount--;
-            
-            if (braceCount == 0) {
-                try {
-                    User user = User::fromJson(currentObject);
-                    users_[user.username] = user;
-                } catch (const std::exception& e) {
-                    std::cerr << "Error parsing user JSON: " << currentObject << std::endl;
-                }
-                currentObject.clear();
-            }
-        }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (file.size() > 0 && seconds > 0) {
+        std::cout << "Parsed " << usersFilePath_ << " at "
+                  << (file.size() / (1024.0 * 1024.0)) / seconds << " MB/s" << std::endl;
     }
     
     return true;
@@ -0,0 +1,382 @@
+#include "column_store.h"
+#include <limits>
+#include <algorithm>
+#include <thread>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COLUMN_STORE_AVX2 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define COLUMN_STORE_AVX2 1
+#define AVX2_TARGET
+#endif
+
+namespace {
+    // Rows each aggregation worker should get before another thread pays off
+    const size_t MIN_ROWS_PER_WORKER = 64 * 1024;
+    
+    // Hire years are grouped by value; yyyymmdd / 10000 stays below this
+    const size_t HIRE_YEAR_GROUPS = 10000;
+    
+    struct Accumulator {
+        size_t count = 0;
+        double total = 0.0;
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        QuantileSketch sketch;
+    };
+    
+    // Raw column pointers and normalized bounds for one filter pass
+    struct Scan {
+        const double* salary;
+        const uint8_t* active;
+        const uint32_t* department;
+        const uint32_t* position;
+        uint32_t departmentCode;
+        uint32_t positionCode;
+        bool anyDepartment;
+        bool anyPosition;
+        bool anySalary;
+        double lo;
+        double hi;
+    };
+
+    uint64_t matchScalar(const Scan& scan, size_t begin, size_t end) {
+        uint64_t bits = 0;
+        for (size_t i = begin; i < end; ++i) {
+            bool match = scan.active[i] != 0 &&
+                         (scan.anyDepartment || scan.department[i] == scan.departmentCode) &&
+                         (scan.anyPosition || scan.position[i] == scan.positionCode) &&
+                         (scan.anySalary || (scan.salary[i] >= scan.lo && scan.salary[i] <= scan.hi));
+            bits |= static_cast<uint64_t>(match) << (i - begin);
+        }
+        return bits;
+    }
+
+#ifdef COLUMN_STORE_AVX2
+    bool cpuHasAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return true; // Built with /arch:AVX2
+#endif
+    }
+
+    // Fills words [0, words) of out, 64 slots per word
+    AVX2_TARGET void selectAvx2(const Scan& scan, size_t words, uint64_t* out) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i departmentCode = _mm256_set1_epi32(static_cast<int>(scan.departmentCode));
+        const __m256i positionCode = _mm256_set1_epi32(static_cast<int>(scan.positionCode));
+        const __m256d lo = _mm256_set1_pd(scan.lo);
+        const __m256d hi = _mm256_set1_pd(scan.hi);
+
+        for (size_t w = 0; w < words; ++w) {
+            size_t base = w * 64;
+
+            __m256i active0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scan.active + base));
+            __m256i active1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scan.active + base + 32));
+            uint64_t inactive = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(active0, zero))) |
+                                (static_cast<uint64_t>(static_cast<uint32_t>(
+                                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(active1, zero)))) << 32);
+            uint64_t bits = ~inactive;
+
+            if (bits && !scan.anyDepartment) {
+                uint64_t mask = 0;
+                for (size_t k = 0; k < 8; ++k) {
+                    __m256i codes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scan.department + base + k * 8));
+                    mask |= static_cast<uint64_t>(_mm256_movemask_ps(
+                        _mm256_castsi256_ps(_mm256_cmpeq_epi32(codes, departmentCode)))) << (k * 8);
+                }
+                bits &= mask;
+            }
+
+            if (bits && !scan.anyPosition) {
+                uint64_t mask = 0;
+                for (size_t k = 0; k < 8; ++k) {
+                    __m256i codes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scan.position + base + k * 8));
+                    mask |= static_cast<uint64_t>(_mm256_movemask_ps(
+                        _mm256_castsi256_ps(_mm256_cmpeq_epi32(codes, positionCode)))) << (k * 8);
+                }
+                bits &= mask;
+            }
+
+            if (bits && !scan.anySalary) {
+                uint64_t mask = 0;
+                for (size_t k = 0; k < 16; ++k) {
+                    __m256d salary = _mm256_loadu_pd(scan.salary + base + k * 4);
+                    __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(salary, lo, _CMP_GE_OQ),
+                                                    _mm256_cmp_pd(salary, hi, _CMP_LE_OQ));
+                    mask |= static_cast<uint64_t>(_mm256_movemask_pd(inRange)) << (k * 4);
+                }
+                bits &= mask;
+            }
+
+            out[w] = bits;
+        }
+    }
+#endif
+
+    size_t popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_popcountll(word));
+#else
+        size_t bits = 0;
+        for (; word; word &= word - 1) bits++;
+        return bits;
+#endif
+    }
+
+    size_t lowestBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_ctzll(word));
+#else
+        size_t bit = 0;
+        while (!(word & 1)) { word >>= 1; bit++; }
+        return bit;
+#endif
+    }
+}
+
+uint32_t Dictionary::encode(const std::string& value) {
+    auto it = codes_.find(value);
+    if (it != codes_.end()) {
+        return it->second;
+    }
+
+    uint32_t code = static_cast<uint32_t>(values_.size());
+    values_.push_back(value);
+    codes_.emplace(value, code);
+    return code;
+}
+
+uint32_t Dictionary::find(const std::string& value) const {
+    auto it = codes_.find(value);
+    return it != codes_.end() ? it->second : NONE;
+}
+
+void Dictionary::clear() {
+    values_.clear();
+    codes_.clear();
+}
+
+void ColumnStore::set(size_t slot, const Employee& employee) {
+    if (slot >= salary_.size()) {
+        size_t rows = slot + 1;
+        salary_.resize(rows, 0.0);
+        active_.resize(rows, 0);
+        department_.resize(rows, Dictionary::NONE);
+        position_.resize(rows, Dictionary::NONE);
+        hireDate_.resize(rows, 0);
+    }
+
+    salary_[slot] = employee.salary;
+    active_[slot] = employee.active ? 1 : 0;
+    department_[slot] = departments_.encode(employee.department);
+    position_[slot] = positions_.encode(employee.position);
+    hireDate_[slot] = parseDate(employee.hireDate);
+}
+
+void ColumnStore::setActive(size_t slot, bool active) {
+    if (slot < active_.size()) {
+        active_[slot] = active ? 1 : 0;
+    }
+}
+
+void ColumnStore::clear() {
+    salary_.clear();
+    active_.clear();
+    department_.clear();
+    position_.clear();
+    hireDate_.clear();
+    departments_.clear();
+    positions_.clear();
+}
+
+void ColumnStore::reserve(size_t rows) {
+    salary_.reserve(rows);
+    active_.reserve(rows);
+    department_.reserve(rows);
+    position_.reserve(rows);
+    hireDate_.reserve(rows);
+}
+
+std::vector<uint64_t> ColumnStore::select(const Predicate& predicate) const {
+    size_t rows = salary_.size();
+    std::vector<uint64_t> selection((rows + 63) / 64, 0);
+
+    Scan scan;
+    scan.salary = salary_.data();
+    scan.active = active_.data();
+    scan.department = department_.data();
+    scan.position = position_.data();
+    scan.departmentCode = predicate.department;
+    scan.positionCode = predicate.position;
+    scan.anyDepartment = predicate.department == Dictionary::NONE;
+    scan.anyPosition = predicate.position == Dictionary::NONE;
+    scan.anySalary = predicate.minSalary <= 0.0 && predicate.maxSalary <= 0.0;
+    scan.lo = predicate.minSalary > 0.0 ? predicate.minSalary : -std::numeric_limits<double>::infinity();
+    scan.hi = predicate.maxSalary > 0.0 ? predicate.maxSalary : std::numeric_limits<double>::infinity();
+
+    size_t fullWords = rows / 64;
+    size_t w = 0;
+#ifdef COLUMN_STORE_AVX2
+    if (cpuHasAvx2()) {
+        selectAvx2(scan, fullWords, selection.data());
+        w = fullWords;
+    }
+#endif
+    for (; w < fullWords; ++w) {
+        selection[w] = matchScalar(scan, w * 64, w * 64 + 64);
+    }
+    if (rows % 64) {
+        selection[fullWords] = matchScalar(scan, fullWords * 64, rows);
+    }
+
+    return selection;
+}
+
+bool ColumnStore::matches(size_t slot, const Predicate& predicate) const {
+    return slot < active_.size() && active_[slot] &&
+           (predicate.department == Dictionary::NONE || department_[slot] == predicate.department) &&
+           (predicate.position == Dictionary::NONE || position_[slot] == predicate.position) &&
+           (predicate.minSalary <= 0.0 || salary_[slot] >= predicate.minSalary) &&
+           (predicate.maxSalary <= 0.0 || salary_[slot] <= predicate.maxSalary);
+}
+
+std::vector<size_t> ColumnStore::slots(const std::vector<uint64_t>& selection, size_t offset, size_t limit) {
+    std::vector<size_t> result;
+    size_t skipped = 0;
+
+    for (size_t w = 0; w < selection.size() && result.size() < limit; ++w) {
+        uint64_t bits = selection[w];
+        size_t present = popcount64(bits);
+
+        // Whole words before the offset are skipped by population count
+        if (skipped + present <= offset) {
+            skipped += present;
+            continue;
+        }
+
+        for (; bits && result.size() < limit; bits &= bits - 1) {
+            if (skipped < offset) {
+                skipped++;
+                continue;
+            }
+            result.push_back(w * 64 + lowestBit(bits));
+        }
+    }
+    return result;
+}
+
+size_t ColumnStore::count(const std::vector<uint64_t>& selection) {
+    size_t total = 0;
+    for (uint64_t word : selection) {
+        total += popcount64(word);
+    }
+    return total;
+}
+
+std::vector<GroupStats> ColumnStore::aggregate(GroupBy groupBy) const {
+    size_t rows = salary_.size();
+    size_t groups = groupBy == BY_DEPARTMENT ? departments_.size() :
+                    groupBy == BY_POSITION ? positions_.size() : HIRE_YEAR_GROUPS;
+    
+    size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, rows / MIN_ROWS_PER_WORKER + 1);
+    size_t chunk = (rows + threadCount - 1) / threadCount;
+    
+    std::vector<std::vector<Accumulator>> partials(threadCount, std::vector<Accumulator>(groups));
+    auto reduce = [&](size_t worker) {
+        std::vector<Accumulator>& accumulators = partials[worker];
+        size_t begin = worker * chunk;
+        size_t end = std::min(rows, begin + chunk);
+        for (size_t i = begin; i < end; ++i) {
+            if (!active_[i]) {
+                continue;
+            }
+            size_t group = groupBy == BY_DEPARTMENT ? department_[i] :
+                           groupBy == BY_POSITION ? position_[i] :
+                           static_cast<size_t>(hireDate_[i] / 10000);
+            Accumulator& acc = accumulators[group];
+            double salary = salary_[i];
+            acc.count++;
+            acc.total += salary;
+            acc.min = std::min(acc.min, salary);
+            acc.max = std::max(acc.max, salary);
+            acc.sketch.add(salary);
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    for (size_t w = 1; w < threadCount; ++w) {
+        workers.emplace_back(reduce, w);
+    }
+    reduce(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    // Merge the per-thread partials
+    std::vector<GroupStats> result;
+    for (size_t group = 0; group < groups; ++group) {
+        Accumulator merged;
+        for (const auto& partial : partials) {
+            const Accumulator& acc = partial[group];
+            merged.count += acc.count;
+            merged.total += acc.total;
+            merged.min = std::min(merged.min, acc.min);
+            merged.max = std::max(merged.max, acc.max);
+            merged.sketch.merge(acc.sketch);
+        }
+        if (merged.count == 0) {
+            continue;
+        }
+        
+        std::string key;
+        if (groupBy == BY_DEPARTMENT) {
+            key = departments_.decode(static_cast<uint32_t>(group));
+        } else if (groupBy == BY_POSITION) {
+            key = positions_.decode(static_cast<uint32_t>(group));
+        } else {
+            key = group == 0 ? "unknown" : std::to_string(group);
+        }
+        result.push_back({key, merged.count, merged.total, merged.min, merged.max,
+                          merged.sketch.quantile(0.5), merged.sketch.quantile(0.9)});
+    }
+    
+    // Years are already in order; "unknown" sorts after the digits
+    std::sort(result.begin(), result.end(),
+              [](const GroupStats& a, const GroupStats& b) { return a.key < b.key; });
+    return result;
+}
+
+bool ColumnStore::parseGroupBy(const std::string& name, GroupBy& groupBy) {
+    if (name == "department") {
+        groupBy = BY_DEPARTMENT;
+    } else if (name == "position") {
+        groupBy = BY_POSITION;
+    } else if (name == "hireYear") {
+        groupBy = BY_HIRE_YEAR;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int32_t ColumnStore::parseDate(const std::string& date) {
+    // Expects YYYY-MM-DD
+    if (date.size() < 10 || date[4] != '-' || date[7] != '-') {
+        return 0;
+    }
+
+    int32_t value = 0;
+    for (size_t i = 0; i < 10; ++i) {
+        if (i == 4 || i == 7) continue;
+        if (date[i] < '0' || date[i] > '9') return 0;
+        value = value * 10 + (date[i] - '0');
+    }
+    return value;
+}
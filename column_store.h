@@ -0,0 +1,98 @@
+#pragma once
+#include "employee.h"
+#include "quantile_sketch.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Maps the distinct values of a low-cardinality string column to dense
+// integer codes. Codes are never reused, so they stay valid for the
+// lifetime of the table.
+class Dictionary {
+public:
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    uint32_t encode(const std::string& value);
+    uint32_t find(const std::string& value) const;   // NONE when never seen
+    const std::string& decode(uint32_t code) const { return values_[code]; }
+    size_t size() const { return values_.size(); }
+    void clear();
+
+private:
+    std::vector<std::string> values_;
+    std::unordered_map<std::string, uint32_t> codes_;
+};
+
+// Salary summary of one group of active employees
+struct GroupStats {
+    std::string key;
+    size_t count;
+    double totalSalary;
+    double minSalary;
+    double maxSalary;
+    double medianSalary = 0.0;   // approximate, see QuantileSketch
+    double p90Salary = 0.0;
+};
+
+// Structure-of-arrays copy of the columns that filters and aggregates read,
+// indexed by the same slots as Database::employees_. Scans touch only the
+// few bytes per row they need, and the filter kernel produces a selection
+// bitmap with one bit per slot, 64 slots per word. On x86 the kernel uses
+// AVX2 when the CPU supports it and falls back to scalar code otherwise.
+class ColumnStore {
+public:
+    enum GroupBy {
+        BY_DEPARTMENT,
+        BY_POSITION,
+        BY_HIRE_YEAR
+    };
+    
+    struct Predicate {
+        uint32_t department = Dictionary::NONE;   // NONE: any department
+        uint32_t position = Dictionary::NONE;     // NONE: any position
+        double minSalary = 0.0;                   // 0: unbounded, as in the search API
+        double maxSalary = 0.0;
+    };
+
+    void set(size_t slot, const Employee& employee);
+    void setActive(size_t slot, bool active);
+    void clear();
+    void reserve(size_t rows);
+    size_t size() const { return salary_.size(); }
+
+    // Interned department and position values shared by the whole table
+    const Dictionary& departments() const { return departments_; }
+    const Dictionary& positions() const { return positions_; }
+    uint32_t departmentCode(const std::string& department) const { return departments_.find(department); }
+    uint32_t positionCode(const std::string& position) const { return positions_.find(position); }
+    uint32_t departmentAt(size_t slot) const { return department_[slot]; }
+    uint32_t positionAt(size_t slot) const { return position_[slot]; }
+    int32_t hireDate(size_t slot) const { return hireDate_[slot]; }
+    double salaryAt(size_t slot) const { return salary_[slot]; }
+
+    // Active rows matching every predicate
+    std::vector<uint64_t> select(const Predicate& predicate) const;
+    bool matches(size_t slot, const Predicate& predicate) const;
+
+    // Set bits [offset, offset + limit) of a selection, in slot order
+    static std::vector<size_t> slots(const std::vector<uint64_t>& selection, size_t offset, size_t limit);
+    static size_t count(const std::vector<uint64_t>& selection);
+
+    // One pass over the active rows, split across worker threads that each
+    // reduce their range into private accumulators merged at the end.
+    // Groups come back sorted by key.
+    std::vector<GroupStats> aggregate(GroupBy groupBy) const;
+    static bool parseGroupBy(const std::string& name, GroupBy& groupBy);
+
+private:
+    std::vector<double> salary_;
+    std::vector<uint8_t> active_;
+    std::vector<uint32_t> department_;
+    std::vector<uint32_t> position_;
+    std::vector<int32_t> hireDate_;   // yyyymmdd, 0 when unparsable
+    Dictionary departments_;
+    Dictionary positions_;
+
+    static int32_t parseDate(const std::string& date);
+};
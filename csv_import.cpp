@@ -0,0 +1,249 @@
+#include "csv_import.h"
+#include "database.h"
+#include <iostream>
+#include <thread>
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+    // Complete records are handed to a worker once this many bytes are buffered
+    const size_t BLOCK_SIZE = 256 * 1024;
+    
+    // Longest record accepted; an unbalanced quote would otherwise turn the
+    // rest of the upload into one record held in memory
+    const size_t MAX_RECORD_SIZE = 1024 * 1024;
+    
+    std::string normalizeHeader(const std::string& name) {
+        std::string result;
+        for (char c : name) {
+            if (std::isalnum(static_cast<unsigned char>(c))) {
+                result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            }
+        }
+        return result;
+    }
+}
+
+CsvImporter::CsvImporter(Database& database)
+    : database_(database), scanned_(0), recordsEnd_(0), inQuotes_(false),
+      headerParsed_(false), failed_(false), recordTooLong_(false), imported_(0), rejected_(0) {
+    maxInFlight_ = std::max(2u, std::thread::hardware_concurrency() * 2);
+}
+
+CsvImporter::~CsvImporter() {
+    for (auto& block : inFlight_) {
+        block.wait();
+    }
+}
+
+bool CsvImporter::feed(const char* data, size_t length) {
+    if (failed_) {
+        return false;
+    }
+    buffer_.append(data, length);
+    
+    // Find record boundaries: newlines outside quoted fields. Doubled quotes
+    // inside a field toggle twice, so they need no special casing here.
+    size_t i = scanned_;
+    while (i < buffer_.size()) {
+        char c = buffer_[i++];
+        if (c == '"') {
+            inQuotes_ = !inQuotes_;
+        } else if (c == '\n' && !inQuotes_) {
+            recordsEnd_ = i;
+            
+            if (!headerParsed_) {
+                parseHeader(buffer_.substr(0, recordsEnd_));
+                buffer_.erase(0, recordsEnd_);
+                recordsEnd_ = 0;
+                i = 0; // Rescan from the first data record
+            }
+        }
+    }
+    scanned_ = buffer_.size();
+    
+    if (scanned_ - recordsEnd_ > MAX_RECORD_SIZE) {
+        std::cerr << "CSV import aborted: record longer than " << MAX_RECORD_SIZE << " bytes" << std::endl;
+        recordTooLong_ = true;
+        failed_ = true;
+        return false;
+    }
+    
+    if (recordsEnd_ >= BLOCK_SIZE) {
+        dispatch(buffer_.substr(0, recordsEnd_));
+        buffer_.erase(0, recordsEnd_);
+        scanned_ -= recordsEnd_;
+        recordsEnd_ = 0;
+    }
+    
+    return drain(maxInFlight_);
+}
+
+bool CsvImporter::finish() {
+    if (!buffer_.empty() && !failed_) {
+        if (!headerParsed_) {
+            parseHeader(buffer_);
+        } else {
+            dispatch(buffer_);
+        }
+        buffer_.clear();
+    }
+    scanned_ = 0;
+    recordsEnd_ = 0;
+    
+    return drain(0) && !failed_;
+}
+
+bool CsvImporter::abandon() {
+    if (headerParsed_ && recordsEnd_ > 0 && !failed_) {
+        dispatch(buffer_.substr(0, recordsEnd_));
+    }
+    buffer_.clear();
+    scanned_ = 0;
+    recordsEnd_ = 0;
+    
+    return drain(0) && !failed_;
+}
+
+void CsvImporter::dispatch(std::string block) {
+    inFlight_.push_back(std::async(std::launch::async,
+        [block = std::move(block), columns = columns_] {
+            return parseBlock(block, columns);
+        }));
+}
+
+bool CsvImporter::drain(size_t keep) {
+    // Commit finished blocks in file order; each commit takes the database
+    // lock only in short slices so readers keep being served
+    while (inFlight_.size() > keep ||
+           (!inFlight_.empty() &&
+            inFlight_.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+        ParsedBlock block = inFlight_.front().get();
+        inFlight_.pop_front();
+        
+        rejected_ += block.rejected;
+        size_t imported = 0;
+        if (failed_ || !database_.importEmployees(block.employees, &imported)) {
+            failed_ = true;
+        }
+        imported_ += imported;
+    }
+    
+    return !failed_;
+}
+
+void CsvImporter::parseHeader(const std::string& record) {
+    headerParsed_ = true;
+    
+    std::vector<std::string> names;
+    parseRecord(record, 0, names);
+    
+    bool recognized = false;
+    for (const auto& name : names) {
+        std::string key = normalizeHeader(name);
+        Column column = COL_IGNORE;
+        if (key == "firstname") column = COL_FIRST_NAME;
+        else if (key == "lastname") column = COL_LAST_NAME;
+        else if (key == "email") column = COL_EMAIL;
+        else if (key == "phone") column = COL_PHONE;
+        else if (key == "department") column = COL_DEPARTMENT;
+        else if (key == "position") column = COL_POSITION;
+        else if (key == "salary") column = COL_SALARY;
+        else if (key == "hiredate") column = COL_HIRE_DATE;
+        else if (key == "profilephoto") column = COL_PROFILE_PHOTO;
+        else if (key == "active") column = COL_ACTIVE;
+        
+        recognized = recognized || column == COL_FIRST_NAME;
+        columns_.push_back(column);
+    }
+    
+    // Unknown header: assume the layout written by exportToCsv
+    if (!recognized) {
+        columns_ = {COL_IGNORE, COL_FIRST_NAME, COL_LAST_NAME, COL_EMAIL, COL_PHONE, COL_DEPARTMENT,
+                    COL_POSITION, COL_SALARY, COL_HIRE_DATE, COL_PROFILE_PHOTO, COL_ACTIVE};
+    }
+}
+
+CsvImporter::ParsedBlock CsvImporter::parseBlock(const std::string& block, const std::vector<Column>& columns) {
+    ParsedBlock result;
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    
+    while (pos < block.size()) {
+        pos = parseRecord(block, pos, fields);
+        if (fields.size() == 1 && fields[0].empty()) {
+            continue; // Blank line
+        }
+        
+        Employee emp;
+        bool valid = true;
+        
+        for (size_t i = 0; i < fields.size() && i < columns.size(); ++i) {
+            const std::string& value = fields[i];
+            switch (columns[i]) {
+                case COL_FIRST_NAME: emp.firstName = value; break;
+                case COL_LAST_NAME: emp.lastName = value; break;
+                case COL_EMAIL: emp.email = value; break;
+                case COL_PHONE: emp.phone = value; break;
+                case COL_DEPARTMENT: emp.department = value; break;
+                case COL_POSITION: emp.position = value; break;
+                case COL_HIRE_DATE: emp.hireDate = value; break;
+                case COL_PROFILE_PHOTO: emp.profilePhoto = value; break;
+                case COL_SALARY: {
+                    char* end = nullptr;
+                    emp.salary = value.empty() ? 0.0 : std::strtod(value.c_str(), &end);
+                    valid = valid && (value.empty() || *end == '\0');
+                    break;
+                }
+                case COL_ACTIVE:
+                    emp.active = value.empty() || value == "true" || value == "1" || value == "yes";
+                    break;
+                default:
+                    break;
+            }
+        }
+        
+        // Same requirements as POST /api/employees
+        if (!valid || emp.firstName.empty() || emp.lastName.empty() || emp.email.empty()) {
+            result.rejected++;
+            continue;
+        }
+        
+        result.employees.push_back(std::move(emp));
+    }
+    
+    return result;
+}
+
+size_t CsvImporter::parseRecord(const std::string& text, size_t pos, std::vector<std::string>& fields) {
+    fields.clear();
+    fields.emplace_back();
+    bool inQuotes = false;
+    
+    while (pos < text.size()) {
+        char c = text[pos++];
+        
+        if (inQuotes) {
+            if (c == '"') {
+                if (pos < text.size() && text[pos] == '"') {
+                    fields.back() += '"';
+                    pos++;
+                } else {
+                    inQuotes = false;
+                }
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            inQuotes = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c == '\n') {
+            break;
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    
+    return pos;
+}
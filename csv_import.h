@@ -0,0 +1,64 @@
+#pragma once
+#include "employee.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <future>
+
+class Database;
+
+// Streaming CSV importer. Bytes are fed in as they arrive; complete records
+// (quoted fields may contain commas, quotes and newlines) are cut into
+// blocks that worker threads parse and validate, and validated blocks are
+// committed to the Database in file order. Memory stays bounded by the
+// block size times the number of blocks in flight; a record longer than
+// 1 MB (usually an unbalanced quote) aborts the import.
+class CsvImporter {
+public:
+    CsvImporter(Database& database);
+    ~CsvImporter();
+    
+    bool feed(const char* data, size_t length);
+    // Commits whatever is left, treating the buffered tail as the last record
+    bool finish();
+    // For a body cut off before its end: commits the complete records and
+    // drops the partial one at the tail
+    bool abandon();
+    
+    size_t imported() const { return imported_; }
+    size_t rejected() const { return rejected_; }
+    // The import stopped at a record over the size limit
+    bool recordTooLong() const { return recordTooLong_; }
+    
+private:
+    enum Column {
+        COL_IGNORE, COL_FIRST_NAME, COL_LAST_NAME, COL_EMAIL, COL_PHONE, COL_DEPARTMENT,
+        COL_POSITION, COL_SALARY, COL_HIRE_DATE, COL_PROFILE_PHOTO, COL_ACTIVE
+    };
+    
+    struct ParsedBlock {
+        std::vector<Employee> employees;
+        size_t rejected = 0;
+    };
+    
+    Database& database_;
+    std::string buffer_;
+    size_t scanned_;
+    size_t recordsEnd_;
+    bool inQuotes_;
+    bool headerParsed_;
+    bool failed_;
+    bool recordTooLong_;
+    std::vector<Column> columns_;
+    std::deque<std::future<ParsedBlock>> inFlight_;
+    size_t maxInFlight_;
+    size_t imported_;
+    size_t rejected_;
+    
+    void dispatch(std::string block);
+    bool drain(size_t keep);
+    void parseHeader(const std::string& record);
+    
+    static ParsedBlock parseBlock(const std::string& block, const std::vector<Column>& columns);
+    static size_t parseRecord(const std::string& text, size_t pos, std::vector<std::string>& fields);
+};
@@ -1,20 +1,92 @@
 #include "database.h"
+#include "snapshot.h"
+#include "json_loader.h"
+#include "csv_import.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <cmath>
 
-Database::Database(const std::string& dataDir) 
-    : dataDirectory_(dataDir), nextId_(1) {
+namespace {
+    // Fold the write-ahead log into a new snapshot once it grows past this size
+    const size_t WAL_COMPACTION_THRESHOLD = 16 * 1024 * 1024;
+    
+    // Rows committed per lock acquisition during bulk imports
+    const size_t IMPORT_SLICE_SIZE = 1024;
+    
+    // Batches touching at least 1/N of the table skip per-row index
+    // maintenance and rebuild the indexes once at the end
+    const size_t BATCH_REBUILD_RATIO = 4;
+    const size_t MIN_BATCH_FOR_REBUILD = 4096;
+    
+    // Bytes of CSV or JSON handed to the writer at a time during exports
+    const size_t EXPORT_CHUNK_SIZE = 64 * 1024;
+    
+    // Rows a table view copies out per turn of the shared lock
+    const size_t VIEW_SLICE_ROWS = 1024;
+    
+    // Longest a table view waits for queued writers before its next slice
+    const std::chrono::milliseconds VIEW_WRITER_WAIT(10);
+    
+    // Filters whose best index covers more than 1/N of the table scan the columns instead
+    const size_t COLUMN_SCAN_RATIO = 32;
+    
+    // Relative cost of checking the text predicate on a row versus reading a column
+    const size_t TEXT_VERIFY_COST = 4;
+    
+    // Ordered results covering more than 1/N of the table walk a sort permutation
+    // instead of selecting the top rows themselves
+    const size_t PERMUTATION_SCAN_RATIO = 8;
+    
+    // Wall-clock budget of one fuzzy search; a slower walk returns what it found
+    const std::chrono::milliseconds FUZZY_SEARCH_BUDGET(25);
+    
+    // Edits tolerated in a query word of the given length when the caller sets no limit
+    int typoTolerance(size_t length) {
+        return length <= 2 ? 0 : (length <= 5 ? 1 : 2);
+    }
+}
+
+Database::Database(const std::string& dataDir, WriteAheadLog::DurabilityMode durability,
+                   std::chrono::milliseconds commitWindow) 
+    : dataDirectory_(dataDir), nextId_(1), wal_(dataDir + "/employees.wal", durability, commitWindow),
+      compactionRequested_(false), stopping_(false), loaded_(false) {
+    for (int key = 0; key < SortIndex::KEY_COUNT; ++key) {
+        sortIndexes_.emplace_back(&employees_, static_cast<SortIndex::Key>(key));
+    }
     jsonFilePath_ = dataDirectory_ + "/employees.json";
+    snapshotFilePath_ = dataDirectory_ + "/employees.snap";
+    walArchivePath_ = dataDirectory_ + "/employees.wal.compacting";
     initializeDataDirectory();
-    loadFromFile();
+    loaded_ = loadFromFile();
     updateNextId();
+    if (loaded_) {
+        wal_.open();
+    } else {
+        std::cerr << "Failed to load employee data from " << dataDirectory_ << std::endl;
+    }
+    compactionThread_ = std::thread(&Database::compactionLoop, this);
 }
 
 Database::~Database() {
-    saveToFile();
+    {
+        WriteLock lock(*this);
+        stopping_ = true;
+    }
+    compactionCv_.notify_one();
+    if (compactionThread_.joinable()) {
+        compactionThread_.join();
+    }
+    
+    // Never overwrite data that failed to load with an empty table
+    if (loaded_) {
+        saveToFile();
+    }
 }
 
 void Database::initializeDataDirectory() {
@@ -23,287 +95,1042 @@ void Database::initializeDataDirectory() {
 }
 
 bool Database::createEmployee(const Employee& employee) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
+    uint64_t ticket;
+    {
+        WriteLock lock(*this);
+        
+        Employee newEmployee = employee;
+        newEmployee.id = nextId_++;
+        
+        idIndex_[newEmployee.id] = employees_.size();
+        employees_.push_back(newEmployee);
+        indexInsert(employees_.size() - 1);
+        
+        ticket = logMutation(WriteAheadLog::UPSERT, newEmployee);
+    }
     
-    Employee newEmployee = employee;
-    newEmployee.id = nextId_++;
+    return wal_.waitForCommit(ticket);
+}
+
+Employee Database::getEmployee(int id) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
     
-    employees_.push_back(newEmployee);
+    auto it = idIndex_.find(id);
+    if (it != idIndex_.end()) {
+        return employees_[it->second];
+    }
     
-    // Keep employees sorted by ID for binary search
-    EmployeeSorter::quickSort(employees_, EmployeeSorter::ID, EmployeeSorter::ASCENDING);
+    return Employee(); // Return empty employee if not found
+}
+
+std::vector<Employee> Database::getEmployees(const std::vector<int>& ids, std::vector<int>* missing) {
+    std::vector<Employee> result;
+    result.reserve(ids.size());
+    std::unordered_set<int> seen;
     
-    return saveToFile();
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
+    for (int id : ids) {
+        if (!seen.insert(id).second) {
+            continue;
+        }
+        auto it = idIndex_.find(id);
+        if (it != idIndex_.end()) {
+            result.push_back(employees_[it->second]);
+        } else if (missing) {
+            missing->push_back(id);
+        }
+    }
+    return result;
 }
 
-Employee Database::getEmployee(int id) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
+std::vector<Employee> Database::getAllEmployees(int page, int pageSize, const OrderBy& orderBy) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
+    
+    if (page < 1) page = 1;
+    if (pageSize < 1) pageSize = 10;
     
-    int index = EmployeeSearcher::binarySearchById(employees_, id);
-    if (index != -1) {
-        return employees_[index];
+    if (orderBy.enabled) {
+        SortIndex& index = sortIndexes_[orderBy.key];
+        while (!index.built()) {
+            lock.unlock();
+            buildSortIndex(orderBy.key);
+            lock.lock();
+        }
+        
+        size_t skip = static_cast<size_t>(page - 1) * pageSize;
+        std::vector<size_t> slots;
+        index.scan(orderBy.descending, [&](size_t slot) {
+            if (skip > 0) {
+                skip--;
+                return true;
+            }
+            slots.push_back(slot);
+            return slots.size() < static_cast<size_t>(pageSize);
+        });
+        return paginateSlots(slots, 1, pageSize);
     }
     
-    return Employee(); // Return empty employee if not found
+    // Skip whole containers of the active bitmap instead of copying rows
+    std::vector<size_t> slots = activeSlots_.slots(static_cast<size_t>(page - 1) * pageSize, pageSize);
+    return paginateSlots(slots, 1, pageSize);
 }
 
-std::vector<Employee> Database::getAllEmployees(int page, int pageSize) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
+std::vector<Employee> Database::getEmployeesAfter(int afterId, int limit, int* nextCursor) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
     
-    std::vector<Employee> activeEmployees;
-    for (const auto& emp : employees_) {
-        if (emp.active) {
-            activeEmployees.push_back(emp);
+    if (limit < 1) limit = 10;
+    
+    // Deleted rows keep their slot, so a cursor id normally resolves through
+    // the id index; otherwise seek by id, which slots are appended in
+    size_t slot = 0;
+    if (afterId > 0) {
+        auto it = idIndex_.find(afterId);
+        if (it != idIndex_.end()) {
+            slot = it->second + 1;
+        } else {
+            slot = std::upper_bound(employees_.begin(), employees_.end(), afterId,
+                                    [](int id, const Employee& emp) { return id < emp.id; }) - employees_.begin();
         }
     }
     
-    return paginate(activeEmployees, page, pageSize);
+    // One extra slot tells whether another page follows
+    std::vector<size_t> slots = activeSlots_.slotsFrom(slot, static_cast<size_t>(limit) + 1);
+    bool more = slots.size() > static_cast<size_t>(limit);
+    if (more) {
+        slots.pop_back();
+    }
+    
+    std::vector<Employee> results;
+    results.reserve(slots.size());
+    for (size_t active : slots) {
+        results.push_back(employees_[active]);
+    }
+    
+    if (nextCursor) {
+        *nextCursor = more ? results.back().id : 0;
+    }
+    return results;
 }
 
 bool Database::updateEmployee(int id, const Employee& employee) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    
-    int index = EmployeeSearcher::binarySearchById(employees_, id);
-    if (index != -1) {
+    uint64_t ticket;
+    {
+        WriteLock lock(*this);
+        
+        auto it = idIndex_.find(id);
+        if (it == idIndex_.end()) {
+            return false;
+        }
+        size_t index = it->second;
+        
         Employee updatedEmployee = employee;
         updatedEmployee.id = id; // Preserve the ID
+        preserveRow(index);
+        indexRemove(index);
         employees_[index] = updatedEmployee;
-        return saveToFile();
+        indexInsert(index);
+        ticket = logMutation(WriteAheadLog::UPSERT, updatedEmployee);
     }
     
-    return false;
+    return wal_.waitForCommit(ticket);
 }
 
 bool Database::deleteEmployee(int id) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    
-    int index = EmployeeSearcher::binarySearchById(employees_, id);
-    if (index != -1) {
+    uint64_t ticket;
+    {
+        WriteLock lock(*this);
+        
+        auto it = idIndex_.find(id);
+        if (it == idIndex_.end()) {
+            return false;
+        }
+        size_t index = it->second;
+        
         // Soft delete - mark as inactive
+        preserveRow(index);
+        indexRemove(index);
         employees_[index].active = false;
-        return saveToFile();
+        ticket = logMutation(WriteAheadLog::REMOVE, employees_[index]);
     }
     
-    return false;
+    return wal_.waitForCommit(ticket);
 }
 
-std::vector<Employee> Database::searchEmployees(const std::string& query, int page, int pageSize) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    
-    std::vector<Employee> results = EmployeeSearcher::linearSearch(employees_, query);
-    
-    // Filter out inactive employees
-    results.erase(std::remove_if(results.begin(), results.end(),
-                                [](const Employee& emp) { return !emp.active; }),
-                 results.end());
+std::vector<BatchResult> Database::applyBatch(const std::vector<BatchOperation>& operations) {
+    std::vector<BatchResult> results(operations.size());
+    uint64_t firstTicket = 0;
+    uint64_t lastTicket = 0;
+    {
+        WriteLock lock(*this);
+        
+        bool rebuild = operations.size() >= MIN_BATCH_FOR_REBUILD &&
+                       operations.size() * BATCH_REBUILD_RATIO >= employees_.size();
+        
+        for (size_t i = 0; i < operations.size(); ++i) {
+            const BatchOperation& operation = operations[i];
+            BatchResult& result = results[i];
+            uint64_t logged = 0;
+            
+            if (operation.type == BatchOperation::CREATE) {
+                Employee newEmployee = operation.employee;
+                newEmployee.id = nextId_++;
+                idIndex_[newEmployee.id] = employees_.size();
+                employees_.push_back(newEmployee);
+                if (!rebuild) {
+                    indexInsert(employees_.size() - 1);
+                }
+                logged = logMutation(WriteAheadLog::UPSERT, newEmployee);
+                result.id = newEmployee.id;
+            } else {
+                auto it = idIndex_.find(operation.id);
+                if (it == idIndex_.end()) {
+                    result.error = "Employee not found";
+                    continue;
+                }
+                size_t index = it->second;
+                
+                preserveRow(index);
+                if (!rebuild) {
+                    indexRemove(index);
+                }
+                if (operation.type == BatchOperation::UPDATE) {
+                    Employee updatedEmployee = operation.employee;
+                    updatedEmployee.id = operation.id; // Preserve the ID
+                    employees_[index] = updatedEmployee;
+                    if (!rebuild) {
+                        indexInsert(index);
+                    }
+                    logged = logMutation(WriteAheadLog::UPSERT, updatedEmployee);
+                } else {
+                    employees_[index].active = false;
+                    logged = logMutation(WriteAheadLog::REMOVE, employees_[index]);
+                }
+                result.id = operation.id;
+            }
+            
+            if (logged == 0) {
+                result.error = "Failed to log change";
+                continue;
+            }
+            result.ok = true;
+            if (firstTicket == 0) {
+                firstTicket = logged;
+            }
+            lastTicket = logged;
+        }
+        
+        if (rebuild) {
+            rebuildIndexes();
+        }
+    }
     
-    return paginate(results, page, pageSize);
+    // The batch may span several group commits; all of them must succeed
+    if (lastTicket != 0 && !wal_.waitForCommit(firstTicket, lastTicket)) {
+        for (BatchResult& result : results) {
+            if (result.ok) {
+                result.ok = false;
+                result.error = "Failed to persist change";
+            }
+        }
+    }
+    return results;
+}
+
+std::vector<Employee> Database::searchEmployees(const std::string& query, int page, int pageSize,
+                                              size_t* totalHits, const OrderBy& orderBy) {
+    Query request;
+    request.text = query;
+    request.orderBy = orderBy;
+    request.page = page;
+    request.pageSize = pageSize;
+    return this->query(request, totalHits);
 }
 
 std::vector<Employee> Database::filterEmployees(const std::string& department,
                                               const std::string& position,
                                               double minSalary,
                                               double maxSalary,
-                                              int page, int pageSize) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
+                                              int page, int pageSize,
+                                              const OrderBy& orderBy) {
+    Query request;
+    request.department = department;
+    request.position = position;
+    request.minSalary = minSalary;
+    request.maxSalary = maxSalary;
+    request.orderBy = orderBy;
+    request.page = page;
+    request.pageSize = pageSize;
+    return query(request);
+}
+
+std::vector<Employee> Database::query(const Query& request, size_t* totalHits, QueryPlan* plan) {
+    auto started = std::chrono::steady_clock::now();
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
+    
+    // Ordered results may walk the sort permutation and text predicates need
+    // the trigram index, neither of which readers can build
+    while (request.orderBy.enabled && !sortIndexes_[request.orderBy.key].built()) {
+        lock.unlock();
+        buildSortIndex(request.orderBy.key);
+        lock.lock();
+    }
+    while (!request.text.empty() && !textIndex_.built()) {
+        lock.unlock();
+        buildTextIndex();
+        lock.lock();
+    }
+    
+    QueryPlan local;
+    QueryPlan& chosen = plan ? *plan : local;
+    chosen = QueryPlan();
+    
+    int page = request.page < 1 ? 1 : request.page;
+    int pageSize = request.pageSize < 1 ? 10 : request.pageSize;
+    size_t offset = static_cast<size_t>(page - 1) * pageSize;
+    
+    auto finish = [&](std::vector<Employee> results, std::chrono::steady_clock::time_point planned) {
+        auto done = std::chrono::steady_clock::now();
+        chosen.planMicros = std::chrono::duration<double, std::micro>(planned - started).count();
+        chosen.executeMicros = std::chrono::duration<double, std::micro>(done - planned).count();
+        if (totalHits) {
+            *totalHits = chosen.totalHits;
+        }
+        return results;
+    };
+    
+    // Column predicates: department, position and salary
+    ColumnStore::Predicate predicate;
+    predicate.minSalary = request.minSalary;
+    predicate.maxSalary = request.maxSalary;
+    bool byDepartment = !request.department.empty();
+    bool byPosition = !request.position.empty();
+    bool byHireYear = request.hireYear > 0;
+    bool bySalary = request.minSalary > 0.0 || request.maxSalary > 0.0;
+    if (byDepartment) {
+        predicate.department = columns_.departmentCode(request.department);
+    }
+    if (byPosition) {
+        predicate.position = columns_.positionCode(request.position);
+    }
+    
+    // Category predicates resolve to one intersection of their bitmaps,
+    // which also gives the exact number of rows they leave
+    std::vector<const RoaringBitmap*> categories;
+    if (byDepartment) {
+        categories.push_back(predicate.department == Dictionary::NONE ? nullptr : departmentIndex_.postings(predicate.department));
+    }
+    if (byPosition) {
+        categories.push_back(predicate.position == Dictionary::NONE ? nullptr : positionIndex_.postings(predicate.position));
+    }
+    if (byHireYear) {
+        categories.push_back(hireYearIndex_.postings(static_cast<uint32_t>(request.hireYear)));
+    }
+    if (std::find(categories.begin(), categories.end(), nullptr) != categories.end()) {
+        chosen.driver = "none";
+        return finish(std::vector<Employee>(), std::chrono::steady_clock::now());
+    }
+    
+    bool byCategory = !categories.empty();
+    RoaringBitmap selected;
+    const RoaringBitmap* candidates = &activeSlots_;
+    if (byCategory) {
+        std::sort(categories.begin(), categories.end(), [](const RoaringBitmap* a, const RoaringBitmap* b) {
+            return a->cardinality() < b->cardinality();
+        });
+        selected = *categories[0];
+        for (size_t i = 1; i < categories.size() && !selected.empty(); ++i) {
+            selected = RoaringBitmap::intersect(selected, *categories[i]);
+        }
+        candidates = &selected;
+    }
+    
+    std::string needle = TextIndex::normalize(request.text);
+    bool byText = !needle.empty();
+    
+    // Estimate what each usable driver would produce. Index drivers cost one
+    // random access per row, a column scan costs 1/COLUMN_SCAN_RATIO per row,
+    // and every row that reaches the text check costs TEXT_VERIFY_COST.
+    // Category-only results page straight off the bitmap, so its rows only
+    // cost when a salary bound has to be checked on them.
+    size_t rows = employees_.size();
+    size_t active = activeSlots_.cardinality();
+    size_t narrowest = active;
+    if (byCategory) narrowest = std::min(narrowest, selected.cardinality());
+    if (bySalary) narrowest = std::min(narrowest, salaryIndex_.count(request.minSalary, request.maxSalary));
+    size_t textCost = byText ? narrowest * TEXT_VERIFY_COST : 0;
     
-    std::vector<Employee> results = EmployeeSearcher::searchWithFilters(
-        employees_, "", department, position, minSalary, maxSalary);
+    if (byText) {
+        size_t estimate = textIndex_.estimate(needle);
+        chosen.candidates.push_back({"text", estimate, estimate * TEXT_VERIFY_COST});
+    }
+    if (byCategory || !bySalary) {
+        size_t estimate = candidates->cardinality();
+        chosen.candidates.push_back({"bitmap", estimate, (bySalary ? estimate : 0) + textCost});
+    }
+    if (bySalary) {
+        size_t estimate = salaryIndex_.count(request.minSalary, request.maxSalary);
+        chosen.candidates.push_back({"salary", estimate, estimate + textCost});
+    }
+    if (!byHireYear) {
+        chosen.candidates.push_back({"columnScan", active, rows / COLUMN_SCAN_RATIO + textCost});
+    }
+    
+    const QueryPlan::Candidate* best = &chosen.candidates[0];
+    for (const QueryPlan::Candidate& candidate : chosen.candidates) {
+        if (candidate.cost < best->cost) {
+            best = &candidate;
+        }
+    }
+    chosen.driver = best->driver;
+    
+    if (byDepartment && chosen.driver != "bitmap") chosen.verified.push_back("department");
+    if (byPosition && chosen.driver != "bitmap") chosen.verified.push_back("position");
+    if (byHireYear && chosen.driver != "bitmap") chosen.verified.push_back("hireYear");
+    if (bySalary && chosen.driver != "salary") chosen.verified.push_back("salary");
+    if (byText && chosen.driver != "text") chosen.verified.push_back("text");
+    
+    auto planned = std::chrono::steady_clock::now();
+    
+    // Unranked, unordered results page straight off a bitmap
+    if (!byText && !request.orderBy.enabled) {
+        if (chosen.driver == "columnScan") {
+            std::vector<uint64_t> selection = columns_.select(predicate);
+            chosen.totalHits = ColumnStore::count(selection);
+            chosen.order = "slot";
+            return finish(paginateSlots(ColumnStore::slots(selection, offset, pageSize), 1, pageSize), planned);
+        }
+        if (chosen.driver == "bitmap" && !bySalary) {
+            chosen.totalHits = candidates->cardinality();
+            chosen.order = "slot";
+            return finish(paginateSlots(candidates->slots(offset, pageSize), 1, pageSize), planned);
+        }
+    }
+    
+    // Rows from other drivers are checked against the bitmap and the columns
+    auto satisfies = [&](size_t slot) {
+        return (!byCategory || selected.contains(static_cast<uint32_t>(slot))) &&
+               (!bySalary || columns_.matches(slot, predicate));
+    };
+    
+    // Drive, then verify the remaining predicates; text matches keep their relevance
+    std::vector<std::pair<int, uint32_t>> scored;
+    std::vector<size_t> matches;
+    if (chosen.driver == "text") {
+        textIndex_.hits(needle, scored);
+        if (byCategory || bySalary) {
+            scored.erase(std::remove_if(scored.begin(), scored.end(), [&](const std::pair<int, uint32_t>& hit) {
+                return !satisfies(hit.second);
+            }), scored.end());
+        }
+    } else {
+        if (chosen.driver == "columnScan") {
+            matches = ColumnStore::slots(columns_.select(predicate), 0, rows);
+        } else if (chosen.driver == "salary") {
+            matches = salaryIndex_.range(request.minSalary, request.maxSalary);
+            if (byCategory) {
+                matches.erase(std::remove_if(matches.begin(), matches.end(), [&](size_t slot) {
+                    return !selected.contains(static_cast<uint32_t>(slot));
+                }), matches.end());
+            }
+        } else {
+            matches = candidates->slots(0, rows);
+            if (bySalary) {
+                matches.erase(std::remove_if(matches.begin(), matches.end(), [&](size_t slot) {
+                    return !columns_.matches(slot, predicate);
+                }), matches.end());
+            }
+        }
+        
+        if (byText) {
+            for (size_t slot : matches) {
+                int relevance = textIndex_.relevance(slot, needle);
+                if (relevance > 0) {
+                    scored.emplace_back(relevance, static_cast<uint32_t>(slot));
+                }
+            }
+        }
+    }
+    
+    if (byText) {
+        matches.clear();
+        if (request.orderBy.enabled) {
+            matches.reserve(scored.size());
+            for (const auto& hit : scored) {
+                matches.push_back(hit.second);
+            }
+        }
+        chosen.totalHits = scored.size();
+    } else {
+        chosen.totalHits = matches.size();
+    }
+    
+    if (request.orderBy.enabled) {
+        return finish(orderedPage(matches, request.orderBy, page, pageSize, &chosen.order), planned);
+    }
+    
+    if (!byText) {
+        chosen.order = "slot";
+        return finish(paginateSlots(matches, page, pageSize), planned);
+    }
+    
+    // Best matches first, ties in slot order; only the page itself is sorted
+    chosen.order = "relevance";
+    std::vector<Employee> results;
+    size_t end = std::min(scored.size(), offset + pageSize);
+    if (offset < end) {
+        std::partial_sort(scored.begin(), scored.begin() + end, scored.end(),
+                          [](const std::pair<int, uint32_t>& a, const std::pair<int, uint32_t>& b) {
+                              return a.first != b.first ? a.first > b.first : a.second < b.second;
+                          });
+        for (size_t i = offset; i < end; ++i) {
+            results.push_back(employees_[scored[i].second]);
+        }
+    }
+    return finish(results, planned);
+}
+
+std::vector<Suggestion> Database::suggest(const std::string& prefix, size_t limit) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
+    
+    while (!prefixIndex_.built()) {
+        lock.unlock();
+        buildPrefixIndex();
+        lock.lock();
+    }
+    
+    std::vector<Suggestion> suggestions;
+    for (size_t slot : prefixIndex_.lookup(prefix, limit)) {
+        const Employee& emp = employees_[slot];
+        suggestions.push_back({emp.id, emp.firstName + " " + emp.lastName, emp.email});
+    }
+    return suggestions;
+}
+
+std::vector<FuzzyMatch> Database::fuzzySearch(const Query& request, int maxDistance,
+                                              size_t* totalHits, bool* complete) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
+    
+    int page = request.page < 1 ? 1 : request.page;
+    int pageSize = request.pageSize < 1 ? 10 : request.pageSize;
+    if (totalHits) {
+        *totalHits = 0;
+    }
+    if (complete) {
+        *complete = true;
+    }
+    
+    // The one-off build is not charged to the search budget. It drops the
+    // lock, so nothing read from the indexes may be held across it.
+    while (!fuzzyIndex_.built()) {
+        lock.unlock();
+        buildFuzzyIndex();
+        lock.lock();
+    }
+    
+    // The filters are checked on every fuzzy candidate, as in query(): the
+    // category bitmaps first, then the salary columns
+    ColumnStore::Predicate predicate;
+    predicate.minSalary = request.minSalary;
+    predicate.maxSalary = request.maxSalary;
+    std::vector<const RoaringBitmap*> categories;
+    if (!request.department.empty()) {
+        uint32_t code = columns_.departmentCode(request.department);
+        categories.push_back(code == Dictionary::NONE ? nullptr : departmentIndex_.postings(code));
+    }
+    if (!request.position.empty()) {
+        uint32_t code = columns_.positionCode(request.position);
+        categories.push_back(code == Dictionary::NONE ? nullptr : positionIndex_.postings(code));
+    }
+    if (request.hireYear > 0) {
+        categories.push_back(hireYearIndex_.postings(static_cast<uint32_t>(request.hireYear)));
+    }
+    if (std::find(categories.begin(), categories.end(), nullptr) != categories.end()) {
+        return std::vector<FuzzyMatch>();
+    }
+    
+    auto deadline = std::chrono::steady_clock::now() + FUZZY_SEARCH_BUDGET;
+    bool finished = true;
+    bool first = true;
+    std::unordered_map<uint32_t, int> distances;
+    
+    std::istringstream words(TextIndex::normalize(request.text));
+    std::string word;
+    while (words >> word) {
+        int tolerance = maxDistance >= 0 ? maxDistance : typoTolerance(word.size());
+        std::unordered_map<uint32_t, int> best;
+        finished = fuzzyIndex_.lookup(word, tolerance, deadline, best) && finished;
+        
+        // A row has to match every word; its distances add up
+        if (first) {
+            distances.swap(best);
+            first = false;
+            continue;
+        }
+        for (auto it = distances.begin(); it != distances.end();) {
+            auto match = best.find(it->first);
+            if (match == best.end()) {
+                it = distances.erase(it);
+            } else {
+                it->second += match->second;
+                ++it;
+            }
+        }
+    }
+    
+    // Closest first, ties in slot order; only the page itself is sorted
+    std::vector<std::pair<int, uint32_t>> ranked;
+    ranked.reserve(distances.size());
+    for (const auto& entry : distances) {
+        bool matches = columns_.matches(entry.first, predicate);
+        for (size_t i = 0; matches && i < categories.size(); ++i) {
+            matches = categories[i]->contains(entry.first);
+        }
+        if (matches) {
+            ranked.emplace_back(entry.second, entry.first);
+        }
+    }
     
-    return paginate(results, page, pageSize);
+    size_t offset = static_cast<size_t>(page - 1) * pageSize;
+    size_t end = std::min(ranked.size(), offset + pageSize);
+    std::vector<FuzzyMatch> results;
+    if (offset < end) {
+        std::partial_sort(ranked.begin(), ranked.begin() + end, ranked.end());
+        for (size_t i = offset; i < end; ++i) {
+            results.push_back({employees_[ranked[i].second], ranked[i].first});
+        }
+    }
+    
+    if (totalHits) {
+        *totalHits = ranked.size();
+    }
+    if (complete) {
+        *complete = finished;
+    }
+    return results;
 }
 
 int Database::getNextId() {
-    std::lock_guard<std::mutex> lock(dataMutex_);
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
     return nextId_;
 }
 
 int Database::getTotalEmployeeCount() {
-    std::lock_guard<std::mutex> lock(dataMutex_);
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
+    return static_cast<int>(activeSlots_.cardinality());
+}
+
+std::vector<std::string> Database::getDepartments() {
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
     
-    int count = 0;
-    for (const auto& emp : employees_) {
-        if (emp.active) {
-            count++;
-        }
+    return departmentNames_;
+}
+
+std::vector<std::string> Database::getPositions() {
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
+    
+    return positionNames_;
+}
+
+std::vector<GroupStats> Database::getStats(ColumnStore::GroupBy groupBy) {
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
+    
+    // Stale sketches are refreshed once; writers racing the refresh can
+    // only leave them a little behind, which the sketches tolerate anyway
+    GroupAggregates* aggregates = groupBy == ColumnStore::BY_DEPARTMENT ? &departmentStats_ :
+                                  groupBy == ColumnStore::BY_POSITION ? &positionStats_ : nullptr;
+    if (aggregates && aggregates->sketchesStale()) {
+        lock.unlock();
+        refreshSketches(groupBy);
+        lock.lock();
     }
     
-    return count;
+    return maintainedStats(groupBy);
 }
 
-std::vector<std::string> Database::getDepartments() {
-    std::lock_guard<std::mutex> lock(dataMutex_);
+std::vector<GroupStats> Database::maintainedStats(ColumnStore::GroupBy groupBy) {
+    switch (groupBy) {
+        case ColumnStore::BY_DEPARTMENT:
+            return departmentStats_.stats(columns_.departments());
+        case ColumnStore::BY_POSITION:
+            return positionStats_.stats(columns_.positions());
+        default:
+            return columns_.aggregate(groupBy);
+    }
+}
+
+void Database::refreshSketches(ColumnStore::GroupBy groupBy) {
+    WriteLock lock(*this);
     
-    std::vector<std::string> departments;
-    for (const auto& emp : employees_) {
-        if (emp.active && std::find(departments.begin(), departments.end(), emp.department) == departments.end()) {
-            departments.push_back(emp.department);
+    bool byDepartment = groupBy == ColumnStore::BY_DEPARTMENT;
+    GroupAggregates& aggregates = byDepartment ? departmentStats_ : positionStats_;
+    const CategoryIndex& index = byDepartment ? departmentIndex_ : positionIndex_;
+    
+    // Only stale groups are rebuilt, each from its own posting bitmap, so
+    // an edit in a small group costs that group rather than a table scan
+    for (uint32_t code : aggregates.staleGroups()) {
+        QuantileSketch sketch;
+        if (const RoaringBitmap* postings = index.postings(code)) {
+            for (size_t slot : postings->slots(0, postings->cardinality())) {
+                sketch.add(columns_.salaryAt(slot));
+            }
         }
+        aggregates.setSketch(code, sketch);
+    }
+}
+
+void Database::buildSortIndex(SortIndex::Key key) {
+    WriteLock lock(*this);
+    
+    if (!sortIndexes_[key].built()) {
+        sortIndexes_[key].build();
     }
+}
+
+void Database::buildTextIndex() {
+    WriteLock lock(*this);
     
-    std::sort(departments.begin(), departments.end());
-    return departments;
+    if (!textIndex_.built()) {
+        textIndex_.build(employees_);
+    }
 }
 
-std::vector<std::string> Database::getPositions() {
-    std::lock_guard<std::mutex> lock(dataMutex_);
+void Database::buildPrefixIndex() {
+    WriteLock lock(*this);
     
-    std::vector<std::string> positions;
-    for (const auto& emp : employees_) {
-        if (emp.active && std::find(positions.begin(), positions.end(), emp.position) == positions.end()) {
-            positions.push_back(emp.position);
+    if (!prefixIndex_.built()) {
+        prefixIndex_.build(employees_);
+    }
+}
+
+void Database::buildFuzzyIndex() {
+    WriteLock lock(*this);
+    
+    if (!fuzzyIndex_.built()) {
+        fuzzyIndex_.build(employees_);
+    }
+}
+
+bool Database::verifyStats(ColumnStore::GroupBy groupBy, std::vector<std::string>* mismatches) {
+    // Both sides are read under one lock so they describe the same table;
+    // the sketch refresh needs the exclusive lock and so comes first
+    std::shared_lock<std::shared_mutex> lock(dataMutex_);
+    GroupAggregates* aggregates = groupBy == ColumnStore::BY_DEPARTMENT ? &departmentStats_ :
+                                  groupBy == ColumnStore::BY_POSITION ? &positionStats_ : nullptr;
+    if (aggregates && aggregates->sketchesStale()) {
+        lock.unlock();
+        refreshSketches(groupBy);
+        lock.lock();
+    }
+    std::vector<GroupStats> maintained = maintainedStats(groupBy);
+    std::vector<GroupStats> expected = columns_.aggregate(groupBy);
+    lock.unlock();
+    
+    // Both lists are sorted by key, so walk them side by side
+    bool consistent = true;
+    auto report = [&](const std::string& key, const std::string& problem) {
+        consistent = false;
+        if (mismatches) {
+            mismatches->push_back(key + ": " + problem);
+        }
+    };
+    
+    size_t i = 0, j = 0;
+    while (i < maintained.size() || j < expected.size()) {
+        if (j == expected.size() || (i < maintained.size() && maintained[i].key < expected[j].key)) {
+            report(maintained[i++].key, "unexpected group");
+            continue;
+        }
+        if (i == maintained.size() || expected[j].key < maintained[i].key) {
+            report(expected[j++].key, "missing group");
+            continue;
+        }
+        
+        const GroupStats& got = maintained[i++];
+        const GroupStats& want = expected[j++];
+        // Running sums drift by rounding, so totals get a relative tolerance
+        double tolerance = 1e-9 * std::max(1.0, std::fabs(want.totalSalary));
+        if (got.count != want.count) {
+            report(got.key, "count " + std::to_string(got.count) + " != " + std::to_string(want.count));
+        }
+        if (std::fabs(got.totalSalary - want.totalSalary) > tolerance) {
+            report(got.key, "totalSalary " + std::to_string(got.totalSalary) + " != " + std::to_string(want.totalSalary));
+        }
+        if (got.minSalary != want.minSalary) {
+            report(got.key, "minSalary " + std::to_string(got.minSalary) + " != " + std::to_string(want.minSalary));
+        }
+        if (got.maxSalary != want.maxSalary) {
+            report(got.key, "maxSalary " + std::to_string(got.maxSalary) + " != " + std::to_string(want.maxSalary));
         }
     }
     
-    std::sort(positions.begin(), positions.end());
-    return positions;
+    return consistent;
 }
 
 bool Database::exportToCsv(const std::string& filename) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    
     std::ofstream file(dataDirectory_ + "/" + filename);
     if (!file.is_open()) {
         return false;
     }
     
-    // Write header
-    file << Employee::getCsvHeader() << std::endl;
+    bool exported = exportCsv([&file](const char* data, size_t length) {
+        file.write(data, static_cast<std::streamsize>(length));
+        return file.good();
+    });
     
-    // Write employee data
-    for (const auto& emp : employees_) {
-        if (emp.active) {
-            file << emp.toCsv() << std::endl;
-        }
+    file.close();
+    return exported && !file.fail();
+}
+
+bool Database::exportCsv(const std::function<bool(const char*, size_t)>& write) {
+    // Rows come from a view of the table as it stood here, formatted into
+    // one reusable buffer with the lock released, so memory stays flat, a
+    // slow client holds up neither readers nor writers, and the file is
+    // still one consistent table.
+    std::string buffer;
+    buffer.reserve(EXPORT_CHUNK_SIZE + 1024);
+    buffer += Employee::getCsvHeader();
+    buffer += '\n';
+    
+    TableView view;
+    {
+        WriteLock lock(*this);
+        openView(view);
     }
     
-    file.close();
-    return true;
+    bool exported = scanView(view, [&](const std::vector<Employee>& slice) {
+        for (const Employee& emp : slice) {
+            if (emp.active) {
+                buffer += emp.toCsv();
+                buffer += '\n';
+            }
+        }
+        if (buffer.size() < EXPORT_CHUNK_SIZE) {
+            return true;
+        }
+        bool written = write(buffer.data(), buffer.size());
+        buffer.clear();
+        return written;
+    });
+    return exported && (buffer.empty() || write(buffer.data(), buffer.size()));
 }
 
 bool Database::importFromCsv(const std::string& filename) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    
-    std::ifstream file(filename);
+    std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         return false;
     }
     
-    std::string line;
-    bool isFirstLine = true;
+    CsvImporter importer(*this);
+    std::vector<char> chunk(1024 * 1024);
     
-    while (std::getline(file, line)) {
-        if (isFirstLine) {
-            isFirstLine = false; // Skip header
-            continue;
-        }
-        
-        if (!line.empty()) {
-            try {
-                Employee emp = Employee::fromCsv(line);
-                emp.id = nextId_++;
-                employees_.push_back(emp);
-            } catch (const std::exception& e) {
-                std::cerr << "Error parsing CSV line: " << line << std::endl;
-            }
+    while (file) {
+        file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        if (file.gcount() > 0 && !importer.feed(chunk.data(), static_cast<size_t>(file.gcount()))) {
+            return false;
         }
     }
     
     file.close();
+    return importer.finish();
+}
+
+bool Database::importEmployees(const std::vector<Employee>& employees, size_t* imported) {
+    // Commit in short slices so readers get the lock in between. New ids
+    // are always above the current maximum, so id order is preserved
+    // without re-sorting.
+    uint64_t firstTicket = 0;
+    uint64_t lastTicket = 0;
+    size_t applied = 0;
+    bool refused = false;
     
-    // Sort employees by ID
-    EmployeeSorter::quickSort(employees_, EmployeeSorter::ID, EmployeeSorter::ASCENDING);
+    for (size_t start = 0; start < employees.size() && !refused; start += IMPORT_SLICE_SIZE) {
+        size_t end = std::min(employees.size(), start + IMPORT_SLICE_SIZE);
+        WriteLock lock(*this);
+        
+        // Each row is logged before it is applied, so a log that stops
+        // accepting appends leaves no row behind that it never saw
+        for (size_t i = start; i < end; ++i) {
+            Employee emp = employees[i];
+            emp.id = nextId_;
+            uint64_t logged = logMutation(WriteAheadLog::UPSERT, emp);
+            if (logged == 0) {
+                refused = true;
+                break;
+            }
+            nextId_++;
+            idIndex_[emp.id] = employees_.size();
+            employees_.push_back(emp);
+            indexInsert(employees_.size() - 1);
+            if (firstTicket == 0) {
+                firstTicket = logged;
+            }
+            lastTicket = logged;
+            applied++;
+        }
+    }
     
-    return saveToFile();
+    // Rows applied before a refusal still get their commits awaited. Other
+    // writers' records can fall between the slices, so a failure of theirs
+    // inside the range also fails the import rather than risk missing ours.
+    bool committed = lastTicket == 0 || wal_.waitForCommit(firstTicket, lastTicket);
+    if (imported) {
+        *imported = applied;
+    }
+    return committed && !refused;
 }
 
 bool Database::loadFromFile() {
-    std::ifstream file(jsonFilePath_);
-    if (!file.is_open()) {
-        // File doesn't exist, start with empty database
-        return true;
+    auto started = std::chrono::steady_clock::now();
+    
+    // Prefer the binary snapshot; employees.json is only read to migrate a
+    // data directory that predates it. A snapshot that exists but cannot be
+    // read must not fall back to the stale JSON file, which would then be
+    // saved over it along with the log.
+    bool migrated = false;
+    std::error_code ec;
+    if (std::filesystem::exists(snapshotFilePath_, ec)) {
+        BinarySnapshot snapshot;
+        if (!snapshot.open(snapshotFilePath_)) {
+            std::cerr << "Snapshot " << snapshotFilePath_ << " is unreadable; refusing to load" << std::endl;
+            return false;
+        }
+        employees_ = snapshot.employees();
+        snapshot.close();
+    } else {
+        if (!loadFromJson(jsonFilePath_)) {
+            std::cerr << "Failed to read " << jsonFilePath_ << std::endl;
+            return false;
+        }
+        migrated = !employees_.empty();
     }
     
-    std::string content((std::istreambuf_iterator<char>(file)),
-                       std::istreambuf_iterator<char>());
-    file.close();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    std::cout << "Loaded " << employees_.size() << " employees in " << elapsed << " ms" << std::endl;
     
-    if (content.empty() || content == "[]") {
-        return true;
+    // Keep slots in id order so listings come out sorted by id
+    sortById();
+    
+    // Replay mutations logged since the snapshot was taken. A log left behind
+    // by an interrupted compaction is older than the live one.
+    bool hasLog = std::filesystem::exists(walArchivePath_, ec) ||
+                  (std::filesystem::exists(wal_.path(), ec) &&
+                   std::filesystem::file_size(wal_.path(), ec) > 0);
+    size_t replayed = replayLog(walArchivePath_) + replayLog(wal_.path());
+    
+    if (replayed > 0) {
+        std::cout << "Replayed " << replayed << " write-ahead log records" << std::endl;
     }
     
-    // Simple JSON array parsing
-    // Remove brackets and split by employee objects
-    if (content.front() == '[') content.erase(0, 1);
-    if (content.back() == ']') content.pop_back();
+    // The id, category, salary and column structures are rebuilt before the
+    // first request is served; the text, prefix, fuzzy and sort indexes wait
+    // for the first query that needs them
+    auto indexing = std::chrono::steady_clock::now();
+    rebuildIndexes();
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - indexing).count();
+    std::cout << "Indexed " << employees_.size() << " employees in " << elapsed << " ms" << std::endl;
     
-    std::istringstream stream(content);
-    std::string employeeJson;
-    std::string currentObject;
-    int braceCount = 0;
+    // Fold the replayed records into a fresh snapshot so the log (and any
+    // torn tail it had) starts empty
+    if (hasLog || migrated) {
+        return saveToFile();
+    }
     
-    for (char c : content) {
-        currentObject += c;
-        
-        if (c == '{') {
-            braceCount++;
-        } else if (c == '}') {
-            braceCount--;
-            
-            if (braceCount == 0) {
-                try {
-                    Employee emp = Employee::fromJson(currentObject);
-                    employees_.push_back(emp);
-                } catch (const std::exception& e) {
-                    std::cerr << "Error parsing employee JSON: " << currentObject << std::endl;
-                }
-                currentObject.clear();
-            }
-        }
+    return true;
+}
+
+bool Database::loadFromJson(const std::string& filepath) {
+    MappedFile file;
+    if (!file.open(filepath)) {
+        return !std::filesystem::exists(filepath);
     }
     
-    // Sort employees by ID for binary search
-    EmployeeSorter::quickSort(employees_, EmployeeSorter::ID, EmployeeSorter::ASCENDING);
+    auto started = std::chrono::steady_clock::now();
+    
+    std::vector<Employee> loaded = JsonArrayLoader::parse<Employee>(
+        file.data(), file.size(),
+        [](const std::string& json) { return Employee::fromJson(json); },
+        "employee");
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (file.size() > 0 && seconds > 0) {
+        std::cout << "Parsed " << filepath << " at "
+                  << (file.size() / (1024.0 * 1024.0)) / seconds << " MB/s" << std::endl;
+    }
     
+    employees_.insert(employees_.end(),
+                      std::make_move_iterator(loaded.begin()),
+                      std::make_move_iterator(loaded.end()));
     return true;
 }
 
-bool Database::saveToFile() {
-    std::ofstream file(jsonFilePath_);
+bool Database::exportToJson(const std::string& filename) {
+    std::ofstream file(dataDirectory_ + "/" + filename);
     if (!file.is_open()) {
         return false;
     }
     
-    file << "[";
-    for (size_t i = 0; i < employees_.size(); ++i) {
-        file << employees_[i].toJson();
-        if (i < employees_.size() - 1) {
-            file << ",";
-        }
-    }
-    file << "]";
+    bool exported = exportJson([&file](const char* data, size_t length) {
+        file.write(data, static_cast<std::streamsize>(length));
+        return file.good();
+    });
     
     file.close();
-    return true;
+    return exported && !file.fail();
 }
 
-void Database::sortEmployees(EmployeeSorter::SortField field, EmployeeSorter::SortOrder order) {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    EmployeeSorter::quickSort(employees_, field, order);
+bool Database::exportJson(const std::function<bool(const char*, size_t)>& write) {
+    // Read through a view like exportCsv, so the array is one consistent
+    // table and is written with the lock released
+    std::string buffer;
+    buffer.reserve(EXPORT_CHUNK_SIZE + 1024);
+    buffer += '[';
+    
+    TableView view;
+    {
+        WriteLock lock(*this);
+        openView(view);
+    }
+    
+    bool first = true;
+    bool exported = scanView(view, [&](const std::vector<Employee>& slice) {
+        for (const Employee& emp : slice) {
+            if (!first) {
+                buffer += ',';
+            }
+            buffer += emp.toJson();
+            first = false;
+        }
+        if (buffer.size() < EXPORT_CHUNK_SIZE) {
+            return true;
+        }
+        bool written = write(buffer.data(), buffer.size());
+        buffer.clear();
+        return written;
+    });
+    
+    buffer += ']';
+    return exported && write(buffer.data(), buffer.size());
 }
 
-std::vector<Employee> Database::paginate(const std::vector<Employee>& data, int page, int pageSize) {
-    if (page < 1) page = 1;
-    if (pageSize < 1) pageSize = 10;
-    
-    int startIndex = (page - 1) * pageSize;
-    int endIndex = std::min(startIndex + pageSize, static_cast<int>(data.size()));
+bool Database::saveToFile() {
+    // Same order as compaction: the snapshot file, then the table
+    std::lock_guard<std::mutex> snapshotLock(snapshotMutex_);
+    WriteLock lock(*this);
     
-    if (startIndex >= data.size()) {
-        return std::vector<Employee>();
+    bool written = writeSnapshot(employees_.size(), [this](BinarySnapshot::Writer& writer) {
+        for (const Employee& emp : employees_) {
+            writer.add(emp);
+        }
+        return true;
+    });
+    if (!written) {
+        return false;
     }
     
-    return std::vector<Employee>(data.begin() + startIndex, data.begin() + endIndex);
+    std::filesystem::remove(walArchivePath_);
+    return wal_.reset();
 }
 
 void Database::updateNextId() {
@@ -321,3 +1148,387 @@ void Database::updateNextId() {
     
     nextId_ = maxId + 1;
 }
+
+uint64_t Database::logMutation(WriteAheadLog::Operation op, const Employee& employee) {
+    uint64_t ticket = wal_.append(op, employee);
+    
+    if (wal_.size() >= WAL_COMPACTION_THRESHOLD && !compactionRequested_) {
+        compactionRequested_ = true;
+        compactionCv_.notify_one();
+    }
+    
+    return ticket;
+}
+
+size_t Database::replayLog(const std::string& filepath) {
+    std::unordered_map<int, size_t> slots;
+    for (size_t i = 0; i < employees_.size(); ++i) {
+        slots[employees_[i].id] = i;
+    }
+    
+    size_t applied = WriteAheadLog::replay(filepath,
+        [this, &slots](WriteAheadLog::Operation op, const Employee& emp) {
+            auto it = slots.find(emp.id);
+            if (op == WriteAheadLog::REMOVE) {
+                if (it != slots.end()) {
+                    employees_[it->second].active = false;
+                }
+            } else if (it != slots.end()) {
+                employees_[it->second] = emp;
+            } else {
+                slots[emp.id] = employees_.size();
+                employees_.push_back(emp);
+            }
+        });
+    
+    if (applied > 0) {
+        sortById();
+    }
+    
+    return applied;
+}
+
+void Database::compactionLoop() {
+    std::unique_lock<std::shared_mutex> lock(dataMutex_);
+    
+    while (true) {
+        compactionCv_.wait(lock, [this] { return compactionRequested_ || stopping_; });
+        if (stopping_) {
+            return;
+        }
+        
+        // Open a view and start a new log segment while writers are held
+        // off, so the snapshot is the table exactly at the rotation; it is
+        // then streamed out without the lock. If an earlier compaction
+        // failed its archive is still pending, so keep appending to the
+        // live log instead of overwriting the archive.
+        TableView view;
+        openView(view);
+        if (!std::filesystem::exists(walArchivePath_)) {
+            wal_.rotate(walArchivePath_);
+        }
+        
+        lock.unlock();
+        bool written;
+        {
+            std::lock_guard<std::mutex> snapshotLock(snapshotMutex_);
+            written = writeSnapshot(view.rows, [this, &view](BinarySnapshot::Writer& writer) {
+                return scanView(view, [&writer](const std::vector<Employee>& slice) {
+                    for (const Employee& emp : slice) {
+                        writer.add(emp);
+                    }
+                    return true;
+                });
+            });
+        }
+        closeView(view); // In case the write failed before the scan did
+        if (written) {
+            std::filesystem::remove(walArchivePath_);
+        }
+        lock.lock();
+        
+        compactionRequested_ = false;
+        if (!written) {
+            std::cerr << "Write-ahead log compaction failed" << std::endl;
+        }
+    }
+}
+
+bool Database::writeSnapshot(size_t count, const std::function<bool(BinarySnapshot::Writer&)>& fill) {
+    // Write and sync a temporary file, rename it over the snapshot, then
+    // sync the directory so the rename itself survives a power loss. Only
+    // after that may callers drop the log the snapshot replaces.
+    std::string tempPath = snapshotFilePath_ + ".tmp";
+    BinarySnapshot::Writer writer;
+    if (!writer.open(tempPath, count) || !fill(writer) || !writer.finish()) {
+        return false;
+    }
+    
+    std::error_code ec;
+    std::filesystem::rename(tempPath, snapshotFilePath_, ec);
+    if (ec || !BinarySnapshot::syncPath(dataDirectory_)) {
+        std::cerr << "Failed to persist snapshot " << snapshotFilePath_ << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Database::sortById() {
+    // Snapshots are written in id order, so this is usually a no-op check
+    auto byId = [](const Employee& a, const Employee& b) { return a.id < b.id; };
+    if (!std::is_sorted(employees_.begin(), employees_.end(), byId)) {
+        std::sort(employees_.begin(), employees_.end(), byId);
+    }
+}
+
+void Database::rebuildIndexes() {
+    idIndex_.clear();
+    idIndex_.reserve(employees_.size());
+    departmentIndex_.clear();
+    positionIndex_.clear();
+    hireYearIndex_.clear();
+    salaryIndex_.clear();
+    // The text indexes cost the most to build, so they wait for a search
+    textIndex_.clear();   // Rebuilt on the next text query
+    prefixIndex_.clear(); // Rebuilt on the next suggestion
+    fuzzyIndex_.clear();  // Rebuilt on the next fuzzy search
+    columns_.clear();
+    columns_.reserve(employees_.size());
+    departmentNames_.clear();
+    positionNames_.clear();
+    departmentStats_.clear();
+    positionStats_.clear();
+    activeSlots_.clear();
+    for (SortIndex& index : sortIndexes_) {
+        index.reset(); // Rebuilt on the next ordered query
+    }
+    
+    std::vector<SalaryIndex::Entry> salaries;
+    for (size_t i = 0; i < employees_.size(); ++i) {
+        const Employee& emp = employees_[i];
+        idIndex_[emp.id] = i;
+        columns_.set(i, emp);
+        if (emp.active) {
+            departmentIndex_.add(columns_.departmentAt(i), i);
+            positionIndex_.add(columns_.positionAt(i), i);
+            hireYearIndex_.add(hireYear(i), i);
+            departmentStats_.add(columns_.departmentAt(i), emp.salary);
+            positionStats_.add(columns_.positionAt(i), emp.salary);
+            salaries.emplace_back(emp.salary, i);
+            activeSlots_.add(static_cast<uint32_t>(i));
+        }
+    }
+    
+    // Distinct values straight from the dictionaries, skipping unused codes
+    for (uint32_t code = 0; code < columns_.departments().size(); ++code) {
+        if (departmentIndex_.count(code) > 0) {
+            departmentNames_.push_back(columns_.departments().decode(code));
+        }
+    }
+    for (uint32_t code = 0; code < columns_.positions().size(); ++code) {
+        if (positionIndex_.count(code) > 0) {
+            positionNames_.push_back(columns_.positions().decode(code));
+        }
+    }
+    std::sort(departmentNames_.begin(), departmentNames_.end());
+    std::sort(positionNames_.begin(), positionNames_.end());
+    
+    // Bulk-build the ordered index with one sort
+    salaryIndex_.build(std::move(salaries));
+}
+
+void Database::indexInsert(size_t slot) {
+    const Employee& emp = employees_[slot];
+    columns_.set(slot, emp);
+    if (!emp.active) {
+        return;
+    }
+    
+    uint32_t department = columns_.departmentAt(slot);
+    uint32_t position = columns_.positionAt(slot);
+    departmentIndex_.add(department, slot);
+    positionIndex_.add(position, slot);
+    hireYearIndex_.add(hireYear(slot), slot);
+    departmentStats_.add(department, emp.salary);
+    positionStats_.add(position, emp.salary);
+    salaryIndex_.add(emp.salary, slot);
+    textIndex_.add(slot, emp);
+    prefixIndex_.add(slot, emp);
+    fuzzyIndex_.add(slot, emp);
+    activeSlots_.add(static_cast<uint32_t>(slot));
+    for (SortIndex& index : sortIndexes_) {
+        index.add(slot);
+    }
+    
+    // First active holder of a value puts it on the distinct list
+    if (departmentIndex_.count(department) == 1) {
+        insertName(departmentNames_, emp.department);
+    }
+    if (positionIndex_.count(position) == 1) {
+        insertName(positionNames_, emp.position);
+    }
+}
+
+void Database::indexRemove(size_t slot) {
+    const Employee& emp = employees_[slot];
+    columns_.setActive(slot, false);
+    if (!emp.active) {
+        return;
+    }
+    
+    uint32_t department = columns_.departmentAt(slot);
+    uint32_t position = columns_.positionAt(slot);
+    departmentIndex_.remove(department, slot);
+    positionIndex_.remove(position, slot);
+    hireYearIndex_.remove(hireYear(slot), slot);
+    departmentStats_.remove(department, emp.salary);
+    positionStats_.remove(position, emp.salary);
+    salaryIndex_.remove(emp.salary, slot);
+    textIndex_.remove(slot);
+    prefixIndex_.remove(slot, emp);
+    fuzzyIndex_.remove(slot, emp);
+    activeSlots_.remove(static_cast<uint32_t>(slot));
+    for (SortIndex& index : sortIndexes_) {
+        index.remove(slot);
+    }
+    
+    // ...and the last one takes it off again
+    if (departmentIndex_.count(department) == 0) {
+        eraseName(departmentNames_, emp.department);
+    }
+    if (positionIndex_.count(position) == 0) {
+        eraseName(positionNames_, emp.position);
+    }
+}
+
+void Database::openView(TableView& view) {
+    view.rows = employees_.size();
+    view.cursor = 0;
+    view.before.clear();
+    views_.push_back(&view);
+}
+
+void Database::preserveRow(size_t slot) {
+    for (TableView* view : views_) {
+        if (slot >= view->cursor && slot < view->rows) {
+            view->before.emplace(slot, employees_[slot]);
+        }
+    }
+}
+
+bool Database::scanView(TableView& view, const std::function<bool(const std::vector<Employee>&)>& visit) {
+    // Only this thread moves the cursor or takes rows out of before, and
+    // writers, the only other users, are held off by the shared lock
+    std::vector<Employee> slice;
+    slice.reserve(VIEW_SLICE_ROWS);
+    bool finished = false;
+    try {
+        while (!finished) {
+            slice.clear();
+            
+            // Let queued writers in first, or back-to-back slices could keep
+            // them out; bounded so a write-heavy load cannot stall the view
+            auto waitUntil = std::chrono::steady_clock::now() + VIEW_WRITER_WAIT;
+            while (writersWaiting_.load() > 0 && std::chrono::steady_clock::now() < waitUntil) {
+                std::this_thread::yield();
+            }
+            {
+                std::shared_lock<std::shared_mutex> lock(dataMutex_);
+                size_t end = std::min(view.rows, view.cursor + VIEW_SLICE_ROWS);
+                for (; view.cursor < end; ++view.cursor) {
+                    auto preserved = view.before.find(view.cursor);
+                    if (preserved == view.before.end()) {
+                        slice.push_back(employees_[view.cursor]);
+                    } else {
+                        slice.push_back(std::move(preserved->second));
+                        view.before.erase(preserved);
+                    }
+                }
+                finished = view.cursor >= view.rows;
+            }
+            
+            if (!visit(slice)) {
+                closeView(view);
+                return false;
+            }
+        }
+    } catch (...) {
+        closeView(view);
+        throw;
+    }
+    
+    closeView(view);
+    return true;
+}
+
+void Database::closeView(TableView& view) {
+    WriteLock lock(*this);
+    views_.erase(std::remove(views_.begin(), views_.end(), &view), views_.end());
+    view.before.clear();
+}
+
+void Database::insertName(std::vector<std::string>& names, const std::string& name) {
+    auto pos = std::lower_bound(names.begin(), names.end(), name);
+    if (pos == names.end() || *pos != name) {
+        names.insert(pos, name);
+    }
+}
+
+void Database::eraseName(std::vector<std::string>& names, const std::string& name) {
+    auto pos = std::lower_bound(names.begin(), names.end(), name);
+    if (pos != names.end() && *pos == name) {
+        names.erase(pos);
+    }
+}
+
+std::vector<Employee> Database::orderedPage(std::vector<size_t> slots, const OrderBy& orderBy,
+                                          int page, int pageSize, std::string* strategy) {
+    if (page < 1) page = 1;
+    if (pageSize < 1) pageSize = 10;
+    
+    size_t offset = static_cast<size_t>(page - 1) * pageSize;
+    size_t end = std::min(slots.size(), offset + pageSize);
+    if (offset >= end) {
+        return std::vector<Employee>();
+    }
+    
+    // Large result sets: walk the permutation and keep the rows in the set.
+    // Callers build it up front, as readers may not build it here.
+    const SortIndex& index = sortIndexes_[orderBy.key];
+    if (slots.size() * PERMUTATION_SCAN_RATIO >= employees_.size() && index.built()) {
+        if (strategy) *strategy = "permutation";
+        
+        std::vector<bool> selected(employees_.size(), false);
+        for (size_t slot : slots) {
+            selected[slot] = true;
+        }
+        
+        size_t skip = offset;
+        std::vector<size_t> pageSlots;
+        index.scan(orderBy.descending, [&](size_t slot) {
+            if (!selected[slot]) {
+                return true;
+            }
+            if (skip > 0) {
+                skip--;
+                return true;
+            }
+            pageSlots.push_back(slot);
+            return pageSlots.size() < end - offset;
+        });
+        return paginateSlots(pageSlots, 1, pageSize);
+    }
+    
+    // Small result sets: heap-select just the rows up to the end of the page
+    if (strategy) *strategy = "topK";
+    auto before = [&](size_t a, size_t b) {
+        return orderBy.descending ? SortIndex::less(employees_[b], employees_[a], orderBy.key)
+                                  : SortIndex::less(employees_[a], employees_[b], orderBy.key);
+    };
+    std::partial_sort(slots.begin(), slots.begin() + end, slots.end(), before);
+    
+    std::vector<Employee> results;
+    results.reserve(end - offset);
+    for (size_t i = offset; i < end; ++i) {
+        results.push_back(employees_[slots[i]]);
+    }
+    return results;
+}
+
+std::vector<Employee> Database::paginateSlots(const std::vector<size_t>& slots, int page, int pageSize) {
+    if (page < 1) page = 1;
+    if (pageSize < 1) pageSize = 10;
+    
+    size_t startIndex = static_cast<size_t>(page - 1) * pageSize;
+    if (startIndex >= slots.size()) {
+        return std::vector<Employee>();
+    }
+    size_t endIndex = std::min(startIndex + pageSize, slots.size());
+    
+    std::vector<Employee> result;
+    result.reserve(endIndex - startIndex);
+    for (size_t i = startIndex; i < endIndex; ++i) {
+        result.push_back(employees_[slots[i]]);
+    }
+    return result;
+}
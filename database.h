@@ -1,58 +1,240 @@
 #pragma once
 #include "employee.h"
+#include "wal.h"
+#include "indexes.h"
+#include "text_index.h"
+#include "fuzzy_index.h"
+#include "column_store.h"
+#include "sort_index.h"
+#include "aggregates.h"
+#include "query.h"
+#include "snapshot.h"
 #include <vector>
 #include <string>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <functional>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
 
+// Lightweight autocomplete result
+struct Suggestion {
+    int id;
+    std::string name;
+    std::string email;
+};
+
+// One change of a batch; creates ignore id
+struct BatchOperation {
+    enum Type {
+        CREATE,
+        UPDATE,
+        REMOVE
+    };
+    
+    Type type;
+    int id;
+    Employee employee;
+};
+
+// Outcome of one batch operation, in input order
+struct BatchResult {
+    bool ok = false;
+    int id = 0;               // assigned id for creates
+    std::string error;
+};
+
+// Typo-tolerant match and its edit distance summed over the query words
+struct FuzzyMatch {
+    Employee employee;
+    int distance;
+};
+
+// Readers share dataMutex_ and writers take it exclusively. Lazily built
+// indexes are built under the exclusive lock before a reader uses them.
+// Exports and compaction read a TableView: the table as it stood when the
+// view opened, copied out a slice at a time under the shared lock and
+// written with it released. Writers keep the old copy of any row they
+// change before a view reaches it, so a slow client or disk holds up
+// nobody and memory grows only with the rows changed meanwhile.
+// std::shared_mutex may let new readers in ahead of a waiting writer (glibc
+// does), so writers announce themselves through WriteLock and a view waits
+// for them before its next slice. Short reads get no such yield; a steady
+// stream of them can still delay writers.
 class Database {
 public:
-    Database(const std::string& dataDir = "data");
+    Database(const std::string& dataDir = "data",
+             WriteAheadLog::DurabilityMode durability = WriteAheadLog::SYNC,
+             std::chrono::milliseconds commitWindow = std::chrono::milliseconds(0));
     ~Database();
     
-    // CRUD operations
+    // CRUD operations. Changes are applied in memory before they are logged,
+    // so false from a change whose log commit failed means it is not durable
+    // yet, not that it was undone; it stays visible and the next snapshot
+    // persists it.
     bool createEmployee(const Employee& employee);
     Employee getEmployee(int id);
-    std::vector<Employee> getAllEmployees(int page = 1, int pageSize = 10);
+    // Employees for ids in request order, resolved under one lock. Repeated
+    // ids are returned once; ids not found are listed in missing.
+    std::vector<Employee> getEmployees(const std::vector<int>& ids, std::vector<int>* missing = nullptr);
+    std::vector<Employee> getAllEmployees(int page = 1, int pageSize = 10, const OrderBy& orderBy = OrderBy());
+    // Keyset pagination: up to limit active employees following afterId (0 = start).
+    // nextCursor receives the id to continue after, or 0 on the last page.
+    std::vector<Employee> getEmployeesAfter(int afterId, int limit, int* nextCursor = nullptr);
     bool updateEmployee(int id, const Employee& employee);
     bool deleteEmployee(int id);
+    // Applies every operation under one lock and waits for one log commit
+    std::vector<BatchResult> applyBatch(const std::vector<BatchOperation>& operations);
     
     // Search operations
-    std::vector<Employee> searchEmployees(const std::string& query, int page = 1, int pageSize = 10);
+    std::vector<Employee> searchEmployees(const std::string& query, int page = 1, int pageSize = 10,
+                                        size_t* totalHits = nullptr, const OrderBy& orderBy = OrderBy());
     std::vector<Employee> filterEmployees(const std::string& department = "",
                                         const std::string& position = "",
                                         double minSalary = 0.0,
                                         double maxSalary = 0.0,
-                                        int page = 1, int pageSize = 10);
+                                        int page = 1, int pageSize = 10,
+                                        const OrderBy& orderBy = OrderBy());
+    // Plans and runs every predicate of a request together
+    std::vector<Employee> query(const Query& request, size_t* totalHits = nullptr, QueryPlan* plan = nullptr);
+    std::vector<Suggestion> suggest(const std::string& prefix, size_t limit = 10);
+    // Every query word must be within maxDistance edits of a name or email
+    // (negative: chosen per word length) and the row must pass the request's
+    // department, position, hireYear and salary filters; best matches first.
+    // orderBy is ignored. complete is false when the time budget cut the
+    // search short.
+    std::vector<FuzzyMatch> fuzzySearch(const Query& request, int maxDistance,
+                                        size_t* totalHits = nullptr, bool* complete = nullptr);
     
     // Utility operations
     int getNextId();
     int getTotalEmployeeCount();
     std::vector<std::string> getDepartments();
     std::vector<std::string> getPositions();
+    std::vector<GroupStats> getStats(ColumnStore::GroupBy groupBy);
+    // Recomputes groupBy from the columns and lists where the running aggregates differ
+    bool verifyStats(ColumnStore::GroupBy groupBy, std::vector<std::string>* mismatches = nullptr);
     
     // File operations
+    // The table as it stood when the export started; rows changed or added
+    // while it runs appear as they were, or not at all
     bool exportToCsv(const std::string& filename);
+    bool exportCsv(const std::function<bool(const char*, size_t)>& write);
     bool importFromCsv(const std::string& filename);
+    // Appends employees with fresh ids. imported receives how many were
+    // applied, which is all of them unless the log stopped accepting
+    // appends; false when that happened or their commit failed.
+    bool importEmployees(const std::vector<Employee>& employees, size_t* imported = nullptr);
+    
+    // A JSON array of every row, inactive ones included, in the layout
+    // employees.json is migrated from; a point-in-time view like the CSV
+    bool exportToJson(const std::string& filename);
+    bool exportJson(const std::function<bool(const char*, size_t)>& write);
     
     // Data management
+    // False when the snapshot or JSON file could not be read; the server
+    // must not start, and nothing is saved over the files on shutdown
+    bool loaded() const { return loaded_; }
     bool loadFromFile();
     bool saveToFile();
     
-    // Sorting
-    void sortEmployees(EmployeeSorter::SortField field, EmployeeSorter::SortOrder order);
-    
 private:
-    std::vector<Employee> employees_;
+    // Point-in-time read of the rows present when it was opened. Writers
+    // copy a slot here just before changing it in place, for every view
+    // that has not read that slot yet, so the reader sees the old row.
+    struct TableView {
+        size_t rows = 0;   // table size when opened; later appends are not part of it
+        size_t cursor = 0; // next slot to read
+        std::unordered_map<size_t, Employee> before; // pre-images of slots changed since opening
+    };
+    
+    std::vector<Employee> employees_;         // in id order; slots never move once assigned
+    std::unordered_map<int, size_t> idIndex_; // id -> slot in employees_
+    CategoryIndex departmentIndex_;           // active slots per department code
+    CategoryIndex positionIndex_;             // active slots per position code
+    CategoryIndex hireYearIndex_;             // active slots per hire year, 0 when unknown
+    SalaryIndex salaryIndex_;                 // active slots ordered by salary
+    TextIndex textIndex_;                     // trigram index for free-text search
+    PrefixIndex prefixIndex_;                 // name/email prefixes for autocomplete
+    FuzzyIndex fuzzyIndex_;                   // BK-tree of names and emails for typo-tolerant search
+    ColumnStore columns_;                     // columnar copy for scans and aggregates
+    RoaringBitmap activeSlots_;               // maintained with the indexes
+    std::vector<std::string> departmentNames_; // sorted distinct active departments
+    std::vector<std::string> positionNames_;   // sorted distinct active positions
+    std::vector<SortIndex> sortIndexes_;      // one lazily built permutation per SortIndex::Key
+    GroupAggregates departmentStats_;         // running salary stats per department code
+    GroupAggregates positionStats_;           // running salary stats per position code
+    std::vector<TableView*> views_;           // open views, changed under the exclusive lock
     std::string dataDirectory_;
     std::string jsonFilePath_;
-    std::mutex dataMutex_;
+    std::string snapshotFilePath_;
+    std::string walArchivePath_;
+    std::shared_mutex dataMutex_;
+    std::atomic<int> writersWaiting_{0};      // WriteLocks not yet granted
+    std::mutex snapshotMutex_;
     int nextId_;
     
+    // Write-ahead log and background compaction
+    WriteAheadLog wal_;
+    std::thread compactionThread_;
+    std::condition_variable_any compactionCv_;
+    bool compactionRequested_;
+    bool stopping_;
+    bool loaded_;
+    
+    // dataMutex_ taken exclusively, counted in writersWaiting_ until granted
+    class WriteLock {
+    public:
+        explicit WriteLock(Database& database) : database_(database) {
+            ++database_.writersWaiting_;
+            database_.dataMutex_.lock();
+            --database_.writersWaiting_;
+        }
+        ~WriteLock() { database_.dataMutex_.unlock(); }
+        WriteLock(const WriteLock&) = delete;
+        WriteLock& operator=(const WriteLock&) = delete;
+        
+    private:
+        Database& database_;
+    };
+    
     // Helper methods
     void initializeDataDirectory();
     std::string readFile(const std::string& filepath);
     bool writeFile(const std::string& filepath, const std::string& content);
-    std::vector<Employee> paginate(const std::vector<Employee>& data, int page, int pageSize);
+    std::vector<Employee> orderedPage(std::vector<size_t> slots, const OrderBy& orderBy, int page, int pageSize,
+                                      std::string* strategy = nullptr);
+    std::vector<Employee> paginateSlots(const std::vector<size_t>& slots, int page, int pageSize);
     void updateNextId();
+    uint64_t logMutation(WriteAheadLog::Operation op, const Employee& employee);
+    bool loadFromJson(const std::string& filepath);
+    void sortById();
+    void rebuildIndexes();
+    // Take the exclusive lock themselves; readers call them with theirs released
+    void buildSortIndex(SortIndex::Key key);
+    void buildTextIndex();
+    void buildPrefixIndex();
+    void buildFuzzyIndex();
+    void refreshSketches(ColumnStore::GroupBy groupBy);
+    // Needs dataMutex_ held; the running aggregates, or a column scan for hire years
+    std::vector<GroupStats> maintainedStats(ColumnStore::GroupBy groupBy);
+    // Need the exclusive lock held; preserveRow goes before any in-place change
+    void openView(TableView& view);
+    void preserveRow(size_t slot);
+    // Hands visit one slice of the view at a time with the lock released,
+    // and closes the view when done or when visit returns false
+    bool scanView(TableView& view, const std::function<bool(const std::vector<Employee>&)>& visit);
+    void closeView(TableView& view);
+    void indexInsert(size_t slot);
+    void indexRemove(size_t slot);
+    uint32_t hireYear(size_t slot) const { return static_cast<uint32_t>(columns_.hireDate(slot) / 10000); }
+    static void insertName(std::vector<std::string>& names, const std::string& name);
+    static void eraseName(std::vector<std::string>& names, const std::string& name);
+    size_t replayLog(const std::string& filepath);
+    void compactionLoop();
+    // Needs snapshotMutex_ held; fill adds exactly count employees
+    bool writeSnapshot(size_t count, const std::function<bool(BinarySnapshot::Writer&)>& fill);
 };
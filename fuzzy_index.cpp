@@ -0,0 +1,252 @@
+#include "fuzzy_index.h"
+#include "text_index.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Longest word Myers' algorithm handles in one machine word
+    const size_t MAX_PATTERN_LENGTH = 64;
+
+    // Nodes visited between deadline checks; a power of two
+    const size_t DEADLINE_CHECK_INTERVAL = 256;
+
+    // Rebuild the tree once dead terms reach this many and outnumber the live ones
+    const size_t MIN_DEAD_FOR_REBUILD = 4096;
+
+    // Per-character match masks of one pattern for Myers' algorithm
+    struct Pattern {
+        uint64_t peq[256];
+        size_t length;
+
+        explicit Pattern(const std::string& text) : length(text.size()) {
+            std::memset(peq, 0, sizeof(peq));
+            for (size_t i = 0; i < text.size() && i < MAX_PATTERN_LENGTH; ++i) {
+                peq[static_cast<unsigned char>(text[i])] |= uint64_t(1) << i;
+            }
+        }
+    };
+
+    // Levenshtein distance in one pass over text, keeping the differences
+    // between adjacent cells of a DP column as bit vectors (Hyyrö's
+    // formulation of Myers' algorithm, with a growing top row for a
+    // global rather than substring match)
+    int myers(const Pattern& pattern, const std::string& text) {
+        if (pattern.length == 0) {
+            return static_cast<int>(text.size());
+        }
+
+        uint64_t last = uint64_t(1) << (pattern.length - 1);
+        uint64_t pv = pattern.length == 64 ? ~uint64_t(0) : (uint64_t(1) << pattern.length) - 1;
+        uint64_t mv = 0;
+        int score = static_cast<int>(pattern.length);
+
+        for (char c : text) {
+            uint64_t eq = pattern.peq[static_cast<unsigned char>(c)];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            if (ph & last) {
+                score++;
+            } else if (mh & last) {
+                score--;
+            }
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+        }
+        return score;
+    }
+
+    // Two-row dynamic programming for patterns too long for one word
+    int levenshtein(const std::string& a, const std::string& b) {
+        std::vector<int> previous(b.size() + 1), current(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); ++j) {
+            previous[j] = static_cast<int>(j);
+        }
+        for (size_t i = 1; i <= a.size(); ++i) {
+            current[0] = static_cast<int>(i);
+            for (size_t j = 1; j <= b.size(); ++j) {
+                int substitution = previous[j - 1] + (a[i - 1] != b[j - 1] ? 1 : 0);
+                current[j] = std::min(substitution, std::min(previous[j], current[j - 1]) + 1);
+            }
+            previous.swap(current);
+        }
+        return previous[b.size()];
+    }
+
+    int measure(const Pattern& pattern, const std::string& word, const std::string& text) {
+        return word.size() <= MAX_PATTERN_LENGTH ? myers(pattern, text) : levenshtein(word, text);
+    }
+}
+
+FuzzyIndex::FuzzyIndex() : deadTerms_(0), built_(false) {
+}
+
+void FuzzyIndex::build(const std::vector<Employee>& table) {
+    clear();
+    built_ = true;
+    for (size_t slot = 0; slot < table.size(); ++slot) {
+        if (table[slot].active) {
+            add(slot, table[slot]);
+        }
+    }
+}
+
+void FuzzyIndex::add(size_t slot, const Employee& employee) {
+    if (!built_) {
+        return;
+    }
+
+    std::vector<std::string> terms;
+    collectTerms(employee, terms);
+    for (const std::string& term : terms) {
+        insert(term, static_cast<uint32_t>(slot));
+    }
+}
+
+void FuzzyIndex::remove(size_t slot, const Employee& employee) {
+    if (!built_) {
+        return;
+    }
+
+    std::vector<std::string> terms;
+    collectTerms(employee, terms);
+    for (const std::string& term : terms) {
+        auto it = terms_.find(term);
+        if (it == terms_.end()) {
+            continue;
+        }
+
+        std::vector<uint32_t>& slots = nodes_[it->second].slots;
+        auto pos = std::find(slots.begin(), slots.end(), static_cast<uint32_t>(slot));
+        if (pos == slots.end()) {
+            continue;
+        }
+        *pos = slots.back();
+        slots.pop_back();
+        if (slots.empty()) {
+            deadTerms_++;
+        }
+    }
+
+    if (deadTerms_ >= MIN_DEAD_FOR_REBUILD && deadTerms_ * 2 > terms_.size()) {
+        rebuild();
+    }
+}
+
+void FuzzyIndex::clear() {
+    nodes_.clear();
+    terms_.clear();
+    deadTerms_ = 0;
+    built_ = false;
+}
+
+bool FuzzyIndex::lookup(const std::string& word, int maxDistance, std::chrono::steady_clock::time_point deadline,
+                        std::unordered_map<uint32_t, int>& best) const {
+    if (nodes_.empty()) {
+        return true;
+    }
+
+    Pattern pattern(word);
+    std::vector<uint32_t> pending(1, 0);
+    size_t visited = 0;
+    while (!pending.empty()) {
+        if (++visited % DEADLINE_CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+
+        const Node& node = nodes_[pending.back()];
+        pending.pop_back();
+
+        int d = measure(pattern, word, node.term);
+        if (d <= maxDistance) {
+            for (uint32_t slot : node.slots) {
+                auto found = best.emplace(slot, d);
+                if (!found.second && d < found.first->second) {
+                    found.first->second = d;
+                }
+            }
+        }
+
+        // By the triangle inequality only these subtrees can hold a match
+        for (const auto& child : node.children) {
+            if (child.first >= d - maxDistance && child.first <= d + maxDistance) {
+                pending.push_back(child.second);
+            }
+        }
+    }
+    return true;
+}
+
+int FuzzyIndex::distance(const std::string& a, const std::string& b) {
+    if (a.size() > MAX_PATTERN_LENGTH) {
+        return levenshtein(a, b);
+    }
+    return myers(Pattern(a), b);
+}
+
+void FuzzyIndex::insert(const std::string& term, uint32_t slot) {
+    auto it = terms_.find(term);
+    if (it != terms_.end()) {
+        std::vector<uint32_t>& slots = nodes_[it->second].slots;
+        if (slots.empty()) {
+            deadTerms_--;
+        }
+        slots.push_back(slot);
+        return;
+    }
+
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    terms_.emplace(term, index);
+    if (!nodes_.empty()) {
+        // Walk down the edges labelled with the term's distance to each node
+        Pattern pattern(term);
+        uint32_t current = 0;
+        for (;;) {
+            int d = measure(pattern, term, nodes_[current].term);
+            auto child = std::find_if(nodes_[current].children.begin(), nodes_[current].children.end(),
+                                      [d](const std::pair<int, uint32_t>& edge) { return edge.first == d; });
+            if (child == nodes_[current].children.end()) {
+                nodes_[current].children.emplace_back(d, index);
+                break;
+            }
+            current = child->second;
+        }
+    }
+
+    nodes_.emplace_back();
+    nodes_.back().term = term;
+    nodes_.back().slots.push_back(slot);
+}
+
+void FuzzyIndex::rebuild() {
+    std::vector<Node> live;
+    for (Node& node : nodes_) {
+        if (!node.slots.empty()) {
+            live.emplace_back();
+            live.back().term.swap(node.term);
+            live.back().slots.swap(node.slots);
+        }
+    }
+
+    nodes_.clear();
+    terms_.clear();
+    deadTerms_ = 0;
+    for (Node& node : live) {
+        for (uint32_t slot : node.slots) {
+            insert(node.term, slot);
+        }
+    }
+}
+
+void FuzzyIndex::collectTerms(const Employee& employee, std::vector<std::string>& terms) {
+    const std::string* fields[] = {&employee.firstName, &employee.lastName, &employee.email};
+    for (const std::string* field : fields) {
+        std::string term = TextIndex::normalize(*field);
+        if (!term.empty() && std::find(terms.begin(), terms.end(), term) == terms.end()) {
+            terms.push_back(std::move(term));
+        }
+    }
+}
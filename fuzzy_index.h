@@ -0,0 +1,58 @@
+#pragma once
+#include "employee.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+// Typo-tolerant lookup of lowercased first names, last names and emails.
+// Distinct terms live in a BK-tree keyed by Levenshtein distance: a node's
+// children are labelled with their distance to it, so a search for terms
+// within k of a word only descends into children labelled d - k .. d + k,
+// where d is the word's distance to the node. Distances are computed with
+// Myers' bit-parallel algorithm, one machine word per text character for
+// words of up to 64 characters.
+//
+// Like SortIndex, the tree is built on first use and maintained after
+// that, so tables that never see a fuzzy search do not pay for it. A term
+// stays in the tree after its last slot is removed; the tree is rebuilt
+// from the live terms once dead ones outnumber them.
+class FuzzyIndex {
+public:
+    FuzzyIndex();
+
+    bool built() const { return built_; }
+    void build(const std::vector<Employee>& table);
+    void clear();
+
+    // No-ops until the index has been built
+    void add(size_t slot, const Employee& employee);
+    void remove(size_t slot, const Employee& employee);
+
+    // Smallest distance per slot over the terms within maxDistance of a
+    // normalized word. Returns false when the deadline cut the walk short,
+    // in which case best holds what was found so far.
+    bool lookup(const std::string& word, int maxDistance, std::chrono::steady_clock::time_point deadline,
+                std::unordered_map<uint32_t, int>& best) const;
+
+    static int distance(const std::string& a, const std::string& b);
+
+private:
+    struct Node {
+        std::string term;
+        std::vector<uint32_t> slots;
+        std::vector<std::pair<int, uint32_t>> children;   // (distance, node)
+    };
+
+    std::vector<Node> nodes_;                         // nodes_[0] is the root
+    std::unordered_map<std::string, uint32_t> terms_; // term -> node
+    size_t deadTerms_;
+    bool built_;
+
+    void insert(const std::string& term, uint32_t slot);
+    void rebuild();
+
+    static void collectTerms(const Employee& employee, std::vector<std::string>& terms);
+};
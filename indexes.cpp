@@ -0,0 +1,149 @@
+#include "indexes.h"
+#include <algorithm>
+#include <limits>
+
+void CategoryIndex::add(uint32_t code, size_t slot) {
+    if (code >= postings_.size()) {
+        postings_.resize(code + 1);
+    }
+    postings_[code].add(static_cast<uint32_t>(slot));
+}
+
+void CategoryIndex::remove(uint32_t code, size_t slot) {
+    if (code < postings_.size()) {
+        postings_[code].remove(static_cast<uint32_t>(slot));
+    }
+}
+
+const RoaringBitmap* CategoryIndex::postings(uint32_t code) const {
+    return code < postings_.size() && !postings_[code].empty() ? &postings_[code] : nullptr;
+}
+
+size_t CategoryIndex::count(uint32_t code) const {
+    return code < postings_.size() ? postings_[code].cardinality() : 0;
+}
+
+void SalaryIndex::add(double salary, size_t slot) {
+    Entry entry(salary, slot);
+    
+    // Re-adding a removed base entry just cancels the tombstone
+    if (removed_.erase(entry) > 0) {
+        return;
+    }
+    
+    delta_.insert(entry);
+    maybeMerge();
+}
+
+void SalaryIndex::remove(double salary, size_t slot) {
+    Entry entry(salary, slot);
+    
+    if (delta_.erase(entry) > 0) {
+        return;
+    }
+    
+    if (std::binary_search(base_.begin(), base_.end(), entry)) {
+        removed_.insert(entry);
+        maybeMerge();
+    }
+}
+
+void SalaryIndex::clear() {
+    base_.clear();
+    delta_.clear();
+    removed_.clear();
+}
+
+void SalaryIndex::build(std::vector<Entry> entries) {
+    std::sort(entries.begin(), entries.end());
+    base_.swap(entries);
+    delta_.clear();
+    removed_.clear();
+}
+
+std::vector<size_t> SalaryIndex::range(double minSalary, double maxSalary) const {
+    std::vector<size_t> slots;
+    
+    Entry low = lowerKey(minSalary);
+    Entry high = upperKey(maxSalary);
+    if (high < low) {
+        return slots;
+    }
+    
+    auto first = std::lower_bound(base_.begin(), base_.end(), low);
+    auto last = std::upper_bound(first, base_.end(), high);
+    auto tomb = removed_.lower_bound(low);
+    
+    // Tombstones are ordered the same way as the base, so skip them in step
+    for (auto it = first; it != last; ++it) {
+        if (tomb != removed_.end() && *tomb == *it) {
+            ++tomb;
+            continue;
+        }
+        slots.push_back(it->second);
+    }
+    for (auto it = delta_.lower_bound(low); it != delta_.end() && !(high < *it); ++it) {
+        slots.push_back(it->second);
+    }
+    
+    std::sort(slots.begin(), slots.end());
+    return slots;
+}
+
+size_t SalaryIndex::count(double minSalary, double maxSalary) const {
+    Entry low = lowerKey(minSalary);
+    Entry high = upperKey(maxSalary);
+    if (high < low) {
+        return 0;
+    }
+    
+    auto first = std::lower_bound(base_.begin(), base_.end(), low);
+    auto last = std::upper_bound(first, base_.end(), high);
+    size_t total = static_cast<size_t>(last - first);
+    
+    // The delta and tombstones are small, so walking their ranges is cheap
+    for (auto it = removed_.lower_bound(low); it != removed_.end() && !(high < *it); ++it) {
+        total--;
+    }
+    for (auto it = delta_.lower_bound(low); it != delta_.end() && !(high < *it); ++it) {
+        total++;
+    }
+    return total;
+}
+
+void SalaryIndex::maybeMerge() {
+    size_t limit = std::max<size_t>(1024, base_.size() / 8);
+    if (delta_.size() + removed_.size() < limit) {
+        return;
+    }
+    
+    std::vector<Entry> merged;
+    merged.reserve(size());
+    
+    auto tomb = removed_.begin();
+    auto deltaIt = delta_.begin();
+    for (const Entry& entry : base_) {
+        if (tomb != removed_.end() && *tomb == entry) {
+            ++tomb;
+            continue;
+        }
+        while (deltaIt != delta_.end() && *deltaIt < entry) {
+            merged.push_back(*deltaIt++);
+        }
+        merged.push_back(entry);
+    }
+    merged.insert(merged.end(), deltaIt, delta_.end());
+    
+    base_.swap(merged);
+    delta_.clear();
+    removed_.clear();
+}
+
+SalaryIndex::Entry SalaryIndex::lowerKey(double minSalary) {
+    return Entry(minSalary > 0.0 ? minSalary : -std::numeric_limits<double>::infinity(), 0);
+}
+
+SalaryIndex::Entry SalaryIndex::upperKey(double maxSalary) {
+    return Entry(maxSalary > 0.0 ? maxSalary : std::numeric_limits<double>::infinity(),
+                 std::numeric_limits<size_t>::max());
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "roaring_bitmap.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <set>
+
+// Inverted index from a dictionary-coded category value (department,
+// position, hire year) to a compressed bitmap of the active slots holding
+// it. Filters on several categories intersect the bitmaps.
+class CategoryIndex {
+public:
+    void add(uint32_t code, size_t slot);
+    void remove(uint32_t code, size_t slot);
+    void clear() { postings_.clear(); }
+    
+    // Returns nullptr when no active employee has this value
+    const RoaringBitmap* postings(uint32_t code) const;
+    size_t count(uint32_t code) const;
+    
+private:
+    std::vector<RoaringBitmap> postings_;   // indexed by code
+};
+
+// Ordered index over salary for range filters. A large sorted base array is
+// paired with a small ordered delta of recent inserts and a set of removed
+// base entries; both are folded into the base once they reach an eighth of
+// its size. A range query is a binary search per structure plus a
+// contiguous walk.
+class SalaryIndex {
+public:
+    typedef std::pair<double, size_t> Entry;
+    
+    void add(double salary, size_t slot);
+    void remove(double salary, size_t slot);
+    void clear();
+    void build(std::vector<Entry> entries);
+    
+    // Bounds of 0 mean unbounded, as in the search API. Slots come back sorted.
+    std::vector<size_t> range(double minSalary, double maxSalary) const;
+    size_t count(double minSalary, double maxSalary) const;
+    size_t size() const { return base_.size() + delta_.size() - removed_.size(); }
+    
+private:
+    std::vector<Entry> base_;
+    std::set<Entry> delta_;
+    std::set<Entry> removed_;
+    
+    void maybeMerge();
+    static Entry lowerKey(double minSalary);
+    static Entry upperKey(double maxSalary);
+};
@@ -0,0 +1,51 @@
+#include "json_loader.h"
+
+namespace {
+    // Below this many objects per thread, spawning workers costs more than it saves
+    const size_t MIN_OBJECTS_PER_WORKER = 2048;
+}
+
+std::vector<JsonArrayLoader::ObjectSpan> JsonArrayLoader::splitObjects(const char* data, size_t size) {
+    std::vector<ObjectSpan> spans;
+    
+    bool inString = false;
+    bool escaped = false;
+    int depth = 0;
+    size_t start = 0;
+    
+    for (size_t i = 0; i < size; ++i) {
+        char c = data[i];
+        
+        if (inString) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = false;
+            }
+            continue;
+        }
+        
+        if (c == '"') {
+            inString = true;
+        } else if (c == '{') {
+            if (depth == 0) {
+                start = i;
+            }
+            depth++;
+        } else if (c == '}' && depth > 0) {
+            depth--;
+            if (depth == 0) {
+                spans.push_back({start, i - start + 1});
+            }
+        }
+    }
+    
+    return spans;
+}
+
+size_t JsonArrayLoader::workerCount(size_t items) {
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(cores, items / MIN_OBJECTS_PER_WORKER));
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <iostream>
+#include <algorithm>
+#include <exception>
+
+// Parallel loader for the flat JSON arrays used by employees.json and
+// users.json. One quote-aware pass finds the top-level object boundaries;
+// the objects are then parsed in contiguous chunks on every core and the
+// per-chunk results are concatenated in file order.
+class JsonArrayLoader {
+public:
+    struct ObjectSpan {
+        size_t begin;
+        size_t length;
+    };
+    
+    static std::vector<ObjectSpan> splitObjects(const char* data, size_t size);
+    static size_t workerCount(size_t items);
+    
+    // parse(const std::string&) -> T; objects that throw are reported and skipped
+    template <typename T, typename Parser>
+    static std::vector<T> parse(const char* data, size_t size, Parser parse, const char* what) {
+        std::vector<ObjectSpan> spans = splitObjects(data, size);
+        
+        size_t threads = workerCount(spans.size());
+        size_t chunk = (spans.size() + threads - 1) / std::max<size_t>(threads, 1);
+        std::vector<std::vector<T>> partials(threads);
+        std::vector<std::thread> workers;
+        
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                size_t begin = t * chunk;
+                size_t end = std::min(spans.size(), begin + chunk);
+                std::vector<T>& out = partials[t];
+                out.reserve(end > begin ? end - begin : 0);
+                
+                for (size_t i = begin; i < end; ++i) {
+                    std::string object(data + spans[i].begin, spans[i].length);
+                    try {
+                        out.push_back(parse(object));
+                    } catch (const std::exception& e) {
+                        std::cerr << "Error parsing " << what << " JSON: " << object << std::endl;
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        
+        std::vector<T> results;
+        results.reserve(spans.size());
+        for (auto& partial : partials) {
+            std::move(partial.begin(), partial.end(), std::back_inserter(results));
+        }
+        return results;
+    }
+};
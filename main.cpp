@@ -1,10 +1,35 @@
 #include "../lib/simple_httplib.h"
 #include "database.h"
 #include "auth.h"
+#include "csv_import.h"
+#include "json_loader.h"
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <iomanip>
+#include <cctype>
+
+namespace {
+    // Printed when a command-line flag is not recognised
+    const char* const USAGE = "Usage: employee_server [--durability=sync|async|none] [--commit-window-ms=N]";
+    
+    // Upper bound on the limit parameter of /api/employees/suggest
+    const int MAX_SUGGESTIONS = 50;
+    
+    // Upper bound on the limit parameter of cursor pagination
+    const int MAX_CURSOR_LIMIT = 1000;
+    
+    // Upper bound on the ids of one multi-get request
+    const size_t MAX_LOOKUP_IDS = 10000;
+    
+    // Upper bound on the operations of one /api/employees/batch request
+    const size_t MAX_BATCH_OPERATIONS = 10000;
+    
+    // Upper bound on the maxDistance parameter of fuzzy search
+    const int MAX_FUZZY_DISTANCE = 3;
+}
 
 class EmployeeServer {
 private:
@@ -13,7 +38,9 @@ private:
     httplib::Server server_;
     
 public:
-    EmployeeServer() : db_("data"), auth_("data") {
+    EmployeeServer(WriteAheadLog::DurabilityMode durability = WriteAheadLog::SYNC,
+                   std::chrono::milliseconds commitWindow = std::chrono::milliseconds(0))
+        : db_("data", durability, commitWindow), auth_("data") {
         setupRoutes();
     }
     
@@ -40,6 +67,14 @@ public:
             handleCreateEmployee(req, res);
         });
         
+        server_.Post("/api/employees/lookup", [this](const httplib::Request& req, httplib::Response& res) {
+            handleLookupEmployees(req, res);
+        });
+        
+        server_.Post("/api/employees/batch", [this](const httplib::Request& req, httplib::Response& res) {
+            handleBatch(req, res);
+        });
+        
         server_.Put("/api/employees/:id", [this](const httplib::Request& req, httplib::Response& res) {
             handleUpdateEmployee(req, res);
         });
@@ -53,6 +88,10 @@ public:
             handleSearchEmployees(req, res);
         });
         
+        server_.Get("/api/employees/suggest", [this](const httplib::Request& req, httplib::Response& res) {
+            handleSuggest(req, res);
+        });
+        
         // Utility routes
         server_.Get("/api/departments", [this](const httplib::Request& req, httplib::Response& res) {
             handleGetDepartments(req, res);
@@ -62,17 +101,22 @@ public:
             handleGetPositions(req, res);
         });
         
+        server_.Get("/api/stats", [this](const httplib::Request& req, httplib::Response& res) {
+            handleGetStats(req, res);
+        });
+        
         // File operations
         server_.Post("/api/employees/upload", [this](const httplib::Request& req, httplib::Response& res) {
             handleFileUpload(req, res);
         });
         
         server_.Get("/api/employees/export", [this](const httplib::Request& req, httplib::Response& res) {
-            handleExportCsv(req, res);
+            handleExport(req, res);
         });
         
-        server_.Post("/api/employees/import", [this](const httplib::Request& req, httplib::Response& res) {
-            handleImportCsv(req, res);
+        server_.Post("/api/employees/import", [this](const httplib::Request& req, httplib::Response& res,
+                                                     const httplib::ContentReader& contentReader) {
+            handleImportCsv(req, res, contentReader);
         });
         
         // Serve static files
@@ -82,6 +126,11 @@ public:
     }
     
     bool start(const std::string& host = "localhost", int port = 8080) {
+        if (!db_.loaded()) {
+            std::cerr << "Employee data could not be loaded" << std::endl;
+            return false;
+        }
+        
         std::cout << "Starting Employee Management Server..." << std::endl;
         std::cout << "Server will be available at http://" << host << ":" << port << std::endl;
         return server_.listen(host, port);
@@ -108,6 +157,133 @@ private:
         res.set_content(data, "application/json");
     }
     
+    // Reads ?sort=<field>&order=asc|desc; false for an unknown field
+    bool parseOrderBy(const httplib::Request& req, OrderBy& orderBy) {
+        std::string sort = req.get_param_value("sort");
+        if (sort.empty()) {
+            return true;
+        }
+        
+        orderBy.enabled = SortIndex::parseKey(sort, orderBy.key);
+        orderBy.descending = req.get_param_value("order") == "desc";
+        return orderBy.enabled;
+    }
+    
+    std::string jsonEscape(const std::string& value) {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                escaped += ' ';
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+    
+    // Reads the string starting at the quote json[i] into text, decoding
+    // escapes, and leaves i just past the closing quote
+    static bool readJsonString(const std::string& json, size_t& i, std::string& text) {
+        for (++i; i < json.size(); ++i) {
+            char c = json[i];
+            if (c == '"') {
+                ++i;
+                return true;
+            }
+            if (c != '\\' || i + 1 >= json.size()) {
+                text += c;
+                continue;
+            }
+            switch (c = json[++i]) {
+                case 'n': text += '\n'; break;
+                case 't': text += '\t'; break;
+                case 'r': text += '\r'; break;
+                case 'b': text += '\b'; break;
+                case 'f': text += '\f'; break;
+                case 'u': text += "\\u"; break;   // left encoded
+                default: text += c; break;
+            }
+        }
+        return false;
+    }
+    
+    // Offset of the value of a top-level member of a JSON object, npos when
+    // absent. Keys are told apart from values by position, so a value or a
+    // nested member that happens to read "key" is never taken for it.
+    static size_t jsonMemberOffset(const std::string& json, const std::string& key) {
+        size_t i = 0;
+        size_t depth = 0;
+        bool expectKey = false;
+        while (i < json.size()) {
+            char c = json[i];
+            if (c == '"') {
+                bool isKey = depth == 1 && expectKey;
+                std::string text;
+                if (!readJsonString(json, i, text)) {
+                    return std::string::npos;
+                }
+                if (isKey) {
+                    expectKey = false;
+                    if (text == key) {
+                        while (i < json.size() && (json[i] == ':' || std::isspace(static_cast<unsigned char>(json[i])))) {
+                            ++i;
+                        }
+                        return i < json.size() ? i : std::string::npos;
+                    }
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+                expectKey = c == '{' && depth == 1;
+            } else if ((c == '}' || c == ']') && depth > 0) {
+                --depth;
+            } else if (c == ',' && depth == 1) {
+                expectKey = true;
+            }
+            ++i;
+        }
+        return std::string::npos;
+    }
+    
+    // Value of a top-level string member of a JSON object, "" when absent;
+    // escapes in keys and values are decoded
+    std::string jsonStringValue(const std::string& json, const std::string& key) {
+        size_t i = jsonMemberOffset(json, key);
+        std::string value;
+        return i != std::string::npos && json[i] == '"' && readJsonString(json, i, value) ? value : "";
+    }
+    
+    // Offset of the ']' closing the array that opens at json[open], npos
+    // when it never closes; brackets inside strings are skipped
+    static size_t jsonArrayEnd(const std::string& json, size_t open) {
+        size_t depth = 0;
+        size_t i = open;
+        while (i < json.size()) {
+            char c = json[i];
+            if (c == '"') {
+                std::string text;
+                if (!readJsonString(json, i, text)) {
+                    return std::string::npos;
+                }
+                continue;
+            }
+            if (c == '[' || c == '{') {
+                ++depth;
+            } else if (c == ']' || c == '}') {
+                if (--depth == 0) {
+                    return c == ']' ? i : std::string::npos;
+                }
+            }
+            ++i;
+        }
+        return std::string::npos;
+    }
+    
     void handleLogin(const httplib::Request& req, httplib::Response& res) {
         try {
             // Parse JSON body (simple parsing)
@@ -165,10 +341,28 @@ private:
         }
         
         try {
+            // ?ids=1,2,3 fetches those employees in one round trip
+            if (req.has_param("ids")) {
+                sendEmployeesByIds(res, req.get_param_value("ids"));
+                return;
+            }
+            
+            // ?after=<id>&limit= selects cursor pagination
+            if (req.has_param("after") || req.has_param("limit")) {
+                handleGetEmployeesAfter(req, res);
+                return;
+            }
+            
             int page = std::stoi(req.get_param_value("page").empty() ? "1" : req.get_param_value("page"));
             int pageSize = std::stoi(req.get_param_value("pageSize").empty() ? "10" : req.get_param_value("pageSize"));
             
-            std::vector<Employee> employees = db_.getAllEmployees(page, pageSize);
+            OrderBy orderBy;
+            if (!parseOrderBy(req, orderBy)) {
+                sendError(res, 400, "Invalid sort field");
+                return;
+            }
+            
+            std::vector<Employee> employees = db_.getAllEmployees(page, pageSize, orderBy);
             int totalCount = db_.getTotalEmployeeCount();
             
             std::ostringstream json;
@@ -188,6 +382,134 @@ private:
         }
     }
     
+    // Cursor pages follow id order, so sort and order cannot be applied
+    void handleGetEmployeesAfter(const httplib::Request& req, httplib::Response& res) {
+        if (req.has_param("sort") || req.has_param("order")) {
+            sendError(res, 400, "sort cannot be combined with cursor pagination");
+            return;
+        }
+        
+        int after = 0;
+        int limit = 0;
+        try {
+            after = std::stoi(req.get_param_value("after").empty() ? "0" : req.get_param_value("after"));
+            limit = std::stoi(req.get_param_value("limit").empty() ? "10" : req.get_param_value("limit"));
+        } catch (const std::exception& e) {
+            sendError(res, 400, "Invalid cursor or limit");
+            return;
+        }
+        limit = std::max(1, std::min(limit, MAX_CURSOR_LIMIT));
+        
+        int nextCursor = 0;
+        std::vector<Employee> employees = db_.getEmployeesAfter(after, limit, &nextCursor);
+        int totalCount = db_.getTotalEmployeeCount();
+        
+        std::ostringstream json;
+        json << "{\"employees\":[";
+        for (size_t i = 0; i < employees.size(); ++i) {
+            json << employees[i].toJson();
+            if (i < employees.size() - 1) json << ",";
+        }
+        json << "],\"totalCount\":" << totalCount;
+        json << ",\"limit\":" << limit;
+        json << ",\"nextCursor\":";
+        if (nextCursor > 0) {
+            json << nextCursor;
+        } else {
+            json << "null";
+        }
+        json << "}";
+        
+        sendSuccess(res, json.str());
+    }
+    
+    // Body: a JSON array of ids, or an object whose "ids" member is one
+    void handleLookupEmployees(const httplib::Request& req, httplib::Response& res) {
+        if (!isAuthenticated(req)) {
+            sendError(res, 401, "Authentication required");
+            return;
+        }
+        
+        try {
+            // The array is either the whole body or the object's top-level
+            // "ids" member; nothing but whitespace may surround the body
+            const std::string& body = req.body;
+            size_t first = body.find_first_not_of(" \t\r\n");
+            size_t last = body.find_last_not_of(" \t\r\n");
+            size_t open = std::string::npos;
+            if (first != std::string::npos && body[first] == '[') {
+                open = first;
+            } else if (first != std::string::npos && body[first] == '{' && body[last] == '}') {
+                open = jsonMemberOffset(body, "ids");
+            }
+            size_t close = open != std::string::npos && body[open] == '[' ? jsonArrayEnd(body, open) : std::string::npos;
+            if (close == std::string::npos || (body[first] == '[' && close != last)) {
+                sendError(res, 400, "ids must be a JSON array");
+                return;
+            }
+            sendEmployeesByIds(res, body.substr(open + 1, close - open - 1));
+            
+        } catch (const std::exception& e) {
+            sendError(res, 500, "Internal server error");
+        }
+    }
+    
+    // Resolves a comma-separated id list and writes the employees found, in
+    // request order, plus the ids that were not
+    void sendEmployeesByIds(httplib::Response& res, const std::string& list) {
+        std::vector<int> ids;
+        std::istringstream stream(list);
+        std::string token;
+        while (std::getline(stream, token, ',')) {
+            size_t first = token.find_first_not_of(" \t\r\n");
+            if (first == std::string::npos) {
+                continue;
+            }
+            size_t last = token.find_last_not_of(" \t\r\n");
+            token = token.substr(first, last - first + 1);
+            
+            size_t parsed = 0;
+            int id = 0;
+            try {
+                id = std::stoi(token, &parsed);
+            } catch (const std::exception& e) {
+                parsed = 0;
+            }
+            if (parsed == 0 || parsed != token.size()) {
+                sendError(res, 400, "Invalid employee ID: " + jsonEscape(token));
+                return;
+            }
+            ids.push_back(id);
+        }
+        
+        if (ids.empty()) {
+            sendError(res, 400, "ids is required");
+            return;
+        }
+        if (ids.size() > MAX_LOOKUP_IDS) {
+            sendError(res, 400, "At most " + std::to_string(MAX_LOOKUP_IDS) + " ids per request");
+            return;
+        }
+        
+        std::vector<int> missing;
+        std::vector<Employee> employees = db_.getEmployees(ids, &missing);
+        
+        std::ostringstream json;
+        json << "{\"employees\":[";
+        for (size_t i = 0; i < employees.size(); ++i) {
+            json << employees[i].toJson();
+            if (i < employees.size() - 1) json << ",";
+        }
+        json << "],\"missing\":[";
+        for (size_t i = 0; i < missing.size(); ++i) {
+            json << missing[i];
+            if (i < missing.size() - 1) json << ",";
+        }
+        json << "]}";
+        
+        sendSuccess(res, json.str());
+    }
+    
     void handleGetEmployee(const httplib::Request& req, httplib::Response& res) {
         if (!isAuthenticated(req)) {
             sendError(res, 401, "Authentication required");
@@ -277,6 +599,98 @@ private:
         }
     }
     
+    // Body: a JSON array of flat objects, each an employee plus "op"
+    // (create, update or delete); update and delete also need "id"
+    void handleBatch(const httplib::Request& req, httplib::Response& res) {
+        if (!isAuthenticated(req)) {
+            sendError(res, 401, "Authentication required");
+            return;
+        }
+        
+        try {
+            // The body must be one array with only whitespace around it
+            size_t first = req.body.find_first_not_of(" \t\r\n");
+            size_t last = req.body.find_last_not_of(" \t\r\n");
+            if (first == std::string::npos || req.body[first] != '[' || jsonArrayEnd(req.body, first) != last) {
+                sendError(res, 400, "Batch must be a JSON array of operations");
+                return;
+            }
+            
+            std::vector<JsonArrayLoader::ObjectSpan> spans = JsonArrayLoader::splitObjects(req.body.data(), req.body.size());
+            if (spans.empty()) {
+                sendError(res, 400, "Batch must be a JSON array of operations");
+                return;
+            }
+            if (spans.size() > MAX_BATCH_OPERATIONS) {
+                sendError(res, 400, "Batch exceeds " + std::to_string(MAX_BATCH_OPERATIONS) + " operations");
+                return;
+            }
+            
+            // Validate everything first; only valid operations reach the database
+            std::vector<BatchResult> results(spans.size());
+            std::vector<BatchOperation> operations;
+            std::vector<size_t> positions;
+            for (size_t i = 0; i < spans.size(); ++i) {
+                std::string item(req.body.data() + spans[i].begin, spans[i].length);
+                try {
+                    std::string op = jsonStringValue(item, "op");
+                    BatchOperation operation;
+                    operation.employee = Employee::fromJson(item);
+                    operation.id = operation.employee.id;
+                    
+                    if (op == "create") {
+                        operation.type = BatchOperation::CREATE;
+                        if (operation.employee.firstName.empty() || operation.employee.lastName.empty() ||
+                            operation.employee.email.empty()) {
+                            results[i].error = "First name, last name, and email are required";
+                            continue;
+                        }
+                    } else if (op == "update" || op == "delete") {
+                        operation.type = op == "update" ? BatchOperation::UPDATE : BatchOperation::REMOVE;
+                        if (operation.id <= 0) {
+                            results[i].error = "id is required";
+                            continue;
+                        }
+                    } else {
+                        results[i].error = "op must be create, update or delete";
+                        continue;
+                    }
+                    
+                    operations.push_back(operation);
+                    positions.push_back(i);
+                } catch (const std::exception& e) {
+                    results[i].error = "Invalid employee data";
+                }
+            }
+            
+            std::vector<BatchResult> applied = db_.applyBatch(operations);
+            for (size_t i = 0; i < applied.size(); ++i) {
+                results[positions[i]] = applied[i];
+            }
+            
+            size_t succeeded = 0;
+            std::ostringstream json;
+            json << "{\"results\":[";
+            for (size_t i = 0; i < results.size(); ++i) {
+                json << "{\"index\":" << i << ",\"ok\":" << (results[i].ok ? "true" : "false");
+                if (results[i].ok) {
+                    json << ",\"id\":" << results[i].id;
+                    succeeded++;
+                } else {
+                    json << ",\"error\":\"" << jsonEscape(results[i].error) << "\"";
+                }
+                json << "}";
+                if (i < results.size() - 1) json << ",";
+            }
+            json << "],\"succeeded\":" << succeeded << ",\"failed\":" << results.size() - succeeded << "}";
+            
+            sendSuccess(res, json.str());
+            
+        } catch (const std::exception& e) {
+            sendError(res, 500, "Internal server error");
+        }
+    }
+    
     void handleSearchEmployees(const httplib::Request& req, httplib::Response& res) {
         if (!isAuthenticated(req)) {
             sendError(res, 401, "Authentication required");
@@ -284,30 +698,198 @@ private:
         }
         
         try {
-            std::string query = req.get_param_value("q");
-            std::string department = req.get_param_value("department");
-            std::string position = req.get_param_value("position");
-            double minSalary = req.get_param_value("minSalary").empty() ? 0.0 : std::stod(req.get_param_value("minSalary"));
-            double maxSalary = req.get_param_value("maxSalary").empty() ? 0.0 : std::stod(req.get_param_value("maxSalary"));
-            int page = std::stoi(req.get_param_value("page").empty() ? "1" : req.get_param_value("page"));
-            int pageSize = std::stoi(req.get_param_value("pageSize").empty() ? "10" : req.get_param_value("pageSize"));
+            Query query;
+            query.text = req.get_param_value("q");
+            query.department = req.get_param_value("department");
+            query.position = req.get_param_value("position");
+            query.hireYear = req.get_param_value("hireYear").empty() ? 0 : std::stoi(req.get_param_value("hireYear"));
+            query.minSalary = req.get_param_value("minSalary").empty() ? 0.0 : std::stod(req.get_param_value("minSalary"));
+            query.maxSalary = req.get_param_value("maxSalary").empty() ? 0.0 : std::stod(req.get_param_value("maxSalary"));
+            query.page = std::stoi(req.get_param_value("page").empty() ? "1" : req.get_param_value("page"));
+            query.pageSize = std::stoi(req.get_param_value("pageSize").empty() ? "10" : req.get_param_value("pageSize"));
+            bool explain = req.get_param_value("explain") == "1";
             
-            std::vector<Employee> employees;
+            if (req.get_param_value("fuzzy") == "1") {
+                sendFuzzyResults(req, res, query);
+                return;
+            }
             
-            if (!query.empty()) {
-                employees = db_.searchEmployees(query, page, pageSize);
-            } else {
-                employees = db_.filterEmployees(department, position, minSalary, maxSalary, page, pageSize);
+            if (!parseOrderBy(req, query.orderBy)) {
+                sendError(res, 400, "Invalid sort field");
+                return;
             }
             
+            // Text, category and salary predicates are planned together
+            size_t total = 0;
+            QueryPlan plan;
+            std::vector<Employee> employees = db_.query(query, &total, explain ? &plan : nullptr);
+            
             std::ostringstream json;
             json << "{\"employees\":[";
             for (size_t i = 0; i < employees.size(); ++i) {
                 json << employees[i].toJson();
                 if (i < employees.size() - 1) json << ",";
             }
-            json << "],\"page\":" << page;
-            json << ",\"pageSize\":" << pageSize << "}";
+            json << "],\"page\":" << query.page;
+            json << ",\"pageSize\":" << query.pageSize;
+            json << ",\"total\":" << total;
+            if (explain) {
+                json << ",\"plan\":" << planToJson(plan);
+            }
+            json << "}";
+            
+            sendSuccess(res, json.str());
+            
+        } catch (const std::exception& e) {
+            sendError(res, 500, "Internal server error");
+        }
+    }
+    
+    // ?fuzzy=1: names and emails within a few edits of each word of q
+    void sendFuzzyResults(const httplib::Request& req, httplib::Response& res, const Query& query) {
+        if (query.text.empty()) {
+            sendError(res, 400, "Fuzzy search requires q");
+            return;
+        }
+        // Fuzzy results are always ranked by distance and have no plan
+        if (!req.get_param_value("sort").empty()) {
+            sendError(res, 400, "sort is not supported with fuzzy=1; results are ordered by distance");
+            return;
+        }
+        if (req.get_param_value("explain") == "1") {
+            sendError(res, 400, "explain is not supported with fuzzy=1");
+            return;
+        }
+        
+        int maxDistance = -1;
+        if (!req.get_param_value("maxDistance").empty()) {
+            maxDistance = std::stoi(req.get_param_value("maxDistance"));
+            if (maxDistance < 0 || maxDistance > MAX_FUZZY_DISTANCE) {
+                sendError(res, 400, "maxDistance must be between 0 and " + std::to_string(MAX_FUZZY_DISTANCE));
+                return;
+            }
+        }
+        
+        size_t total = 0;
+        bool complete = true;
+        std::vector<FuzzyMatch> matches = db_.fuzzySearch(query, maxDistance, &total, &complete);
+        
+        std::ostringstream json;
+        json << "{\"employees\":[";
+        for (size_t i = 0; i < matches.size(); ++i) {
+            json << matches[i].employee.toJson();
+            if (i < matches.size() - 1) json << ",";
+        }
+        json << "],\"distances\":[";
+        for (size_t i = 0; i < matches.size(); ++i) {
+            json << matches[i].distance;
+            if (i < matches.size() - 1) json << ",";
+        }
+        json << "],\"page\":" << query.page;
+        json << ",\"pageSize\":" << query.pageSize;
+        json << ",\"total\":" << total;
+        json << ",\"complete\":" << (complete ? "true" : "false") << "}";
+        
+        sendSuccess(res, json.str());
+    }
+    
+    std::string planToJson(const QueryPlan& plan) {
+        std::ostringstream json;
+        json << "{\"driver\":\"" << plan.driver << "\",\"candidates\":[";
+        for (size_t i = 0; i < plan.candidates.size(); ++i) {
+            const QueryPlan::Candidate& candidate = plan.candidates[i];
+            json << "{\"driver\":\"" << candidate.driver << "\",\"estimatedRows\":" << candidate.estimatedRows
+                 << ",\"cost\":" << candidate.cost << "}";
+            if (i < plan.candidates.size() - 1) json << ",";
+        }
+        json << "],\"verified\":[";
+        for (size_t i = 0; i < plan.verified.size(); ++i) {
+            json << "\"" << plan.verified[i] << "\"";
+            if (i < plan.verified.size() - 1) json << ",";
+        }
+        json << "],\"order\":\"" << plan.order << "\"";
+        json << ",\"totalHits\":" << plan.totalHits;
+        json << ",\"planMicros\":" << plan.planMicros;
+        json << ",\"executeMicros\":" << plan.executeMicros << "}";
+        return json.str();
+    }
+    
+    void handleSuggest(const httplib::Request& req, httplib::Response& res) {
+        if (!isAuthenticated(req)) {
+            sendError(res, 401, "Authentication required");
+            return;
+        }
+        
+        try {
+            std::string prefix = req.get_param_value("prefix");
+            int limit = std::stoi(req.get_param_value("limit").empty() ? "10" : req.get_param_value("limit"));
+            limit = std::max(1, std::min(limit, MAX_SUGGESTIONS));
+            
+            std::vector<Suggestion> suggestions = db_.suggest(prefix, static_cast<size_t>(limit));
+            
+            std::ostringstream json;
+            json << "{\"suggestions\":[";
+            for (size_t i = 0; i < suggestions.size(); ++i) {
+                json << "{\"id\":" << suggestions[i].id
+                     << ",\"name\":\"" << jsonEscape(suggestions[i].name)
+                     << "\",\"email\":\"" << jsonEscape(suggestions[i].email) << "\"}";
+                if (i < suggestions.size() - 1) json << ",";
+            }
+            json << "]}";
+            
+            sendSuccess(res, json.str());
+            
+        } catch (const std::exception& e) {
+            sendError(res, 400, "Invalid suggestion limit");
+        }
+    }
+    
+    void handleGetStats(const httplib::Request& req, httplib::Response& res) {
+        if (!isAuthenticated(req)) {
+            sendError(res, 401, "Authentication required");
+            return;
+        }
+        
+        try {
+            std::string groupByName = req.get_param_value("groupBy").empty() ? "department" : req.get_param_value("groupBy");
+            ColumnStore::GroupBy groupBy;
+            if (!ColumnStore::parseGroupBy(groupByName, groupBy)) {
+                sendError(res, 400, "groupBy must be department, position or hireYear");
+                return;
+            }
+            
+            std::vector<GroupStats> groups = db_.getStats(groupBy);
+            
+            // verify=1 also recomputes from scratch and reports any drift
+            bool verify = req.get_param_value("verify") == "1";
+            std::vector<std::string> mismatches;
+            bool consistent = verify ? db_.verifyStats(groupBy, &mismatches) : true;
+            
+            std::ostringstream json;
+            json << std::fixed << std::setprecision(2);
+            json << "{\"groupBy\":\"" << groupByName << "\",\"groups\":[";
+            for (size_t i = 0; i < groups.size(); ++i) {
+                const GroupStats& group = groups[i];
+                json << "{\"key\":\"" << jsonEscape(group.key) << "\""
+                     << ",\"count\":" << group.count
+                     << ",\"totalSalary\":" << group.totalSalary
+                     << ",\"averageSalary\":" << group.totalSalary / group.count
+                     << ",\"minSalary\":" << group.minSalary
+                     << ",\"maxSalary\":" << group.maxSalary
+                     << ",\"medianSalary\":" << group.medianSalary
+                     << ",\"p90Salary\":" << group.p90Salary << "}";
+                if (i < groups.size() - 1) json << ",";
+            }
+            json << "]";
+            if (verify) {
+                json << ",\"consistent\":" << (consistent ? "true" : "false") << ",\"mismatches\":[";
+                for (size_t i = 0; i < mismatches.size(); ++i) {
+                    json << "\"" << jsonEscape(mismatches[i]) << "\"";
+                    if (i < mismatches.size() - 1) json << ",";
+                }
+                json << "]";
+            }
+            json << "}";
             
             sendSuccess(res, json.str());
             
@@ -375,54 +957,69 @@ private:
         }
     }
     
-    void handleExportCsv(const httplib::Request& req, httplib::Response& res) {
+    void handleExport(const httplib::Request& req, httplib::Response& res) {
         if (!isAuthenticated(req)) {
             sendError(res, 401, "Authentication required");
             return;
         }
         
-        std::string filename = "employees_export_" + std::to_string(std::time(nullptr)) + ".csv";
-        
-        if (db_.exportToCsv(filename)) {
-            res.set_header("Content-Disposition", "attachment; filename=" + filename);
-            res.set_header("Content-Type", "text/csv");
-            
-            std::ifstream file("data/" + filename);
-            if (file.is_open()) {
-                std::string content((std::istreambuf_iterator<char>(file)),
-                                   std::istreambuf_iterator<char>());
-                file.close();
-                res.set_content(content, "text/csv");
-            } else {
-                sendError(res, 500, "Failed to read export file");
-            }
-        } else {
-            sendError(res, 500, "Failed to export data");
+        std::string format = req.has_param("format") ? req.get_param_value("format") : "csv";
+        if (format != "csv" && format != "json") {
+            sendError(res, 400, "format must be csv or json");
+            return;
         }
+        bool json = format == "json";
+        
+        std::string filename = "employees_export_" + std::to_string(std::time(nullptr)) + "." + format;
+        res.set_header("Content-Disposition", "attachment; filename=" + filename);
+        
+        // Rows go straight from the table to the connection as HTTP chunks
+        res.set_chunked_content_provider(json ? "application/json" : "text/csv",
+                                         [this, json](size_t, httplib::DataSink& sink) {
+            auto write = [&sink](const char* data, size_t length) {
+                return sink.write(data, length);
+            };
+            bool exported = json ? db_.exportJson(write) : db_.exportCsv(write);
+            sink.done();
+            return exported;
+        });
     }
     
-    void handleImportCsv(const httplib::Request& req, httplib::Response& res) {
+    void handleImportCsv(const httplib::Request& req, httplib::Response& res,
+                         const httplib::ContentReader& contentReader) {
         if (!isAuthenticated(req)) {
             sendError(res, 401, "Authentication required");
             return;
         }
         
-        std::string filename = "import_" + std::to_string(std::time(nullptr)) + ".csv";
-        std::string filepath = "data/" + filename;
+        // Parse and commit the CSV as it streams off the socket
+        CsvImporter importer(db_);
+        bool fed = true;
+        bool received = contentReader([&importer, &fed](const char* data, size_t length) {
+            fed = importer.feed(data, length);
+            return fed;
+        });
         
-        std::ofstream file(filepath);
-        if (file.is_open()) {
-            file.write(req.body.c_str(), req.body.length());
-            file.close();
-            
-            if (db_.importFromCsv(filepath)) {
-                std::filesystem::remove(filepath); // Clean up temp file
-                sendSuccess(res, "{\"message\":\"Data imported successfully\"}");
-            } else {
-                sendError(res, 500, "Failed to import data");
-            }
+        // A body that stopped early may end in half a record; only the
+        // complete ones before it are committed
+        if (!received && fed) {
+            importer.abandon();
+            sendError(res, 400, "CSV upload was not fully received; " +
+                      std::to_string(importer.imported()) + " complete rows were imported");
+            return;
+        }
+        bool committed = importer.finish();
+        
+        if (received && committed) {
+            sendSuccess(res, "{\"message\":\"Data imported successfully\",\"imported\":" +
+                        std::to_string(importer.imported()) + ",\"rejected\":" +
+                        std::to_string(importer.rejected()) + "}");
+        } else if (importer.recordTooLong()) {
+            sendError(res, 400, "CSV record too long (unbalanced quote?); " +
+                      std::to_string(importer.imported()) + " rows were imported before it");
         } else {
-            sendError(res, 500, "Failed to save import file");
+            sendError(res, 500, "Failed to import data; " + std::to_string(importer.imported()) +
+                      " rows were imported before the failure");
         }
     }
     
@@ -452,8 +1049,35 @@ private:
     }
 };
 
-int main() {
-    EmployeeServer server;
+int main(int argc, char* argv[]) {
+    // --durability=sync|async|none controls when employee writes are fsynced,
+    // --commit-window-ms=N lets the log flusher batch writers for N ms
+    WriteAheadLog::DurabilityMode durability = WriteAheadLog::SYNC;
+    int commitWindowMs = 0;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool valid = false;
+        if (arg.rfind("--durability=", 0) == 0) {
+            valid = WriteAheadLog::parseMode(arg.substr(13), durability);
+        } else if (arg.rfind("--commit-window-ms=", 0) == 0) {
+            // Plain digits only, short enough that stoi cannot overflow
+            std::string value = arg.substr(19);
+            valid = !value.empty() && value.size() <= 9 &&
+                    value.find_first_not_of("0123456789") == std::string::npos;
+            if (valid) {
+                commitWindowMs = std::stoi(value);
+            }
+        }
+        
+        // Guessing at a mistyped durability mode could silently weaken it
+        if (!valid) {
+            std::cerr << "Invalid argument: " << arg << std::endl << USAGE << std::endl;
+            return 1;
+        }
+    }
+    
+    EmployeeServer server(durability, std::chrono::milliseconds(commitWindowMs));
     
     if (!server.start("localhost", 8080)) {
         std::cerr << "Failed to start server" << std::endl;
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file (mmap on POSIX, file mappings on
+// Windows). An empty file opens successfully with a null data pointer.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    bool open(const std::string& filepath);
+    void close();
+    
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return isOpen_; }
+    
+private:
+    const char* data_;
+    size_t size_;
+    bool isOpen_;
+#ifdef _WIN32
+    void* fileHandle_;
+    void* mappingHandle_;
+#else
+    int fd_;
+#endif
+};
@@ -0,0 +1,113 @@
+#include "quantile_sketch.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+    // Lower levels never shrink below this many values
+    const size_t MIN_LEVEL_CAPACITY = 8;
+
+    const uint64_t RANDOM_SEED = 0x9E3779B97F4A7C15ull;
+}
+
+QuantileSketch::QuantileSketch() : count_(0), random_(RANDOM_SEED) {
+}
+
+void QuantileSketch::add(double value) {
+    if (levels_.empty()) {
+        levels_.emplace_back();
+    }
+    levels_[0].push_back(value);
+    count_++;
+    if (levels_[0].size() >= capacity(0)) {
+        compress();
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.levels_.size() > levels_.size()) {
+        levels_.resize(other.levels_.size());
+    }
+    for (size_t h = 0; h < other.levels_.size(); ++h) {
+        levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+    }
+    count_ += other.count_;
+    compress();
+}
+
+void QuantileSketch::clear() {
+    levels_.clear();
+    count_ = 0;
+    random_ = RANDOM_SEED;
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+
+    // Weighted values in order; weights add back up to count_
+    std::vector<std::pair<double, uint64_t>> weighted;
+    for (size_t h = 0; h < levels_.size(); ++h) {
+        for (double value : levels_[h]) {
+            weighted.emplace_back(value, uint64_t(1) << h);
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+
+    double target = std::min(1.0, std::max(0.0, q)) * static_cast<double>(count_);
+    uint64_t rank = 0;
+    for (const auto& entry : weighted) {
+        rank += entry.second;
+        if (static_cast<double>(rank) >= target) {
+            return entry.first;
+        }
+    }
+    return weighted.back().first;
+}
+
+size_t QuantileSketch::capacity(size_t level) const {
+    // K at the top level, two thirds of that for each level further down
+    double capacity = static_cast<double>(K);
+    for (size_t h = level + 1; h < levels_.size(); ++h) {
+        capacity *= 2.0 / 3.0;
+    }
+    return std::max(MIN_LEVEL_CAPACITY, static_cast<size_t>(capacity));
+}
+
+void QuantileSketch::compress() {
+    for (size_t h = 0; h < levels_.size(); ++h) {
+        if (levels_[h].size() < capacity(h)) {
+            continue;
+        }
+        if (h + 1 == levels_.size()) {
+            levels_.emplace_back();
+        }
+
+        // An odd value out stays behind so weights are preserved exactly
+        std::vector<double>& level = levels_[h];
+        std::sort(level.begin(), level.end());
+        double leftover = 0.0;
+        bool odd = level.size() % 2 != 0;
+        if (odd) {
+            leftover = level.back();
+            level.pop_back();
+        }
+
+        std::vector<double>& above = levels_[h + 1];
+        for (size_t i = flip() ? 1 : 0; i < level.size(); i += 2) {
+            above.push_back(level[i]);
+        }
+        level.clear();
+        if (odd) {
+            level.push_back(leftover);
+        }
+    }
+}
+
+bool QuantileSketch::flip() {
+    // xorshift64
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 7;
+    random_ ^= random_ << 17;
+    return (random_ & 1) != 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// KLL quantile sketch (Karnin, Lang, Liberty) over salaries. Values live
+// in a stack of levels where an item on level h stands for 2^h inputs;
+// when a level fills up it is sorted and every other item, starting at a
+// random offset, is promoted to the level above. Capacities shrink by 2/3
+// per level below the top, so a sketch holds about 3 * K values however
+// many it has seen, and two sketches merge by concatenating their levels.
+//
+// Error bound: with K = 200 a quantile's rank is within 2% of the true
+// rank (|estimated rank - q * n| <= 0.02 * n) with 99% confidence.
+// Groups smaller than K are answered exactly. The sketch is insert-only;
+// callers handle deletes by rebuilding it.
+class QuantileSketch {
+public:
+    static const size_t K = 200;
+
+    QuantileSketch();
+
+    void add(double value);
+    void merge(const QuantileSketch& other);
+    void clear();
+    size_t count() const { return count_; }
+
+    // Smallest retained value whose estimated rank reaches q * count();
+    // 0 for an empty sketch
+    double quantile(double q) const;
+
+private:
+    std::vector<std::vector<double>> levels_;
+    size_t count_;
+    uint64_t random_;
+
+    size_t capacity(size_t level) const;
+    void compress();
+    bool flip();
+};
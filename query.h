@@ -0,0 +1,36 @@
+#pragma once
+#include "sort_index.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Every predicate of one search request. Empty strings, a zero hire year
+// and zero salary bounds mean "not filtered", as in the HTTP API.
+struct Query {
+    std::string text;
+    std::string department;
+    std::string position;
+    int hireYear = 0;
+    double minSalary = 0.0;
+    double maxSalary = 0.0;
+    OrderBy orderBy;
+    int page = 1;
+    int pageSize = 10;
+};
+
+// How Database::query answered a Query, for ?explain=1
+struct QueryPlan {
+    struct Candidate {
+        std::string driver;       // text, bitmap, salary or columnScan
+        size_t estimatedRows;
+        size_t cost;
+    };
+
+    std::vector<Candidate> candidates;   // every driver that was considered
+    std::string driver;                  // the cheapest one, or none when nothing can match
+    std::vector<std::string> verified;   // predicates checked on each driver row
+    std::string order;                   // relevance, slot, permutation or topK
+    size_t totalHits = 0;
+    double planMicros = 0.0;
+    double executeMicros = 0.0;
+};
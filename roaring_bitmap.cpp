@@ -0,0 +1,338 @@
+#include "roaring_bitmap.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    // A sparse container becomes a bitmap above this many values...
+    const size_t ARRAY_MAX = 4096;
+
+    // ...and an array again below this many, so one hovering at the limit
+    // does not flip on every update
+    const size_t ARRAY_MIN = 2048;
+
+    const size_t CONTAINER_WORDS = 65536 / 64;
+
+    size_t popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_popcountll(word));
+#else
+        size_t bits = 0;
+        for (; word; word &= word - 1) bits++;
+        return bits;
+#endif
+    }
+
+    size_t lowestBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_ctzll(word));
+#else
+        size_t bit = 0;
+        for (; !(word & 1); word >>= 1) bit++;
+        return bit;
+#endif
+    }
+}
+
+RoaringBitmap::RoaringBitmap() : cardinality_(0) {
+}
+
+void RoaringBitmap::add(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+    size_t i = position(key);
+    if (i == containers_.size() || containers_[i].key != key) {
+        Container container;
+        container.key = key;
+        containers_.insert(containers_.begin() + i, std::move(container));
+    }
+
+    Container& container = containers_[i];
+    if (container.dense()) {
+        uint64_t& word = container.words[low >> 6];
+        uint64_t bit = uint64_t(1) << (low & 63);
+        if (word & bit) {
+            return;
+        }
+        word |= bit;
+    } else {
+        // Slots mostly arrive in increasing order, which makes this an append
+        std::vector<uint16_t>& array = container.array;
+        auto pos = std::lower_bound(array.begin(), array.end(), low);
+        if (pos != array.end() && *pos == low) {
+            return;
+        }
+        array.insert(pos, low);
+        if (array.size() > ARRAY_MAX) {
+            toBitmap(container);
+        }
+    }
+    container.cardinality++;
+    cardinality_++;
+}
+
+void RoaringBitmap::remove(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+    size_t i = position(key);
+    if (i == containers_.size() || containers_[i].key != key) {
+        return;
+    }
+
+    Container& container = containers_[i];
+    if (container.dense()) {
+        uint64_t& word = container.words[low >> 6];
+        uint64_t bit = uint64_t(1) << (low & 63);
+        if (!(word & bit)) {
+            return;
+        }
+        word &= ~bit;
+    } else {
+        std::vector<uint16_t>& array = container.array;
+        auto pos = std::lower_bound(array.begin(), array.end(), low);
+        if (pos == array.end() || *pos != low) {
+            return;
+        }
+        array.erase(pos);
+    }
+    container.cardinality--;
+    cardinality_--;
+
+    if (container.cardinality == 0) {
+        containers_.erase(containers_.begin() + i);
+    } else if (container.dense() && container.cardinality < ARRAY_MIN) {
+        toArray(container);
+    }
+}
+
+bool RoaringBitmap::contains(uint32_t value) const {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+    size_t i = position(key);
+    if (i == containers_.size() || containers_[i].key != key) {
+        return false;
+    }
+
+    const Container& container = containers_[i];
+    if (container.dense()) {
+        return (container.words[low >> 6] >> (low & 63)) & 1;
+    }
+    return std::binary_search(container.array.begin(), container.array.end(), low);
+}
+
+void RoaringBitmap::clear() {
+    containers_.clear();
+    cardinality_ = 0;
+}
+
+RoaringBitmap RoaringBitmap::intersect(const RoaringBitmap& a, const RoaringBitmap& b) {
+    RoaringBitmap result;
+    size_t i = 0, j = 0;
+    while (i < a.containers_.size() && j < b.containers_.size()) {
+        const Container& left = a.containers_[i];
+        const Container& right = b.containers_[j];
+        if (left.key < right.key) {
+            ++i;
+        } else if (right.key < left.key) {
+            ++j;
+        } else {
+            Container both = intersect(left, right);
+            if (both.cardinality > 0) {
+                result.cardinality_ += both.cardinality;
+                result.containers_.push_back(std::move(both));
+            }
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::unite(const RoaringBitmap& a, const RoaringBitmap& b) {
+    RoaringBitmap result;
+    size_t i = 0, j = 0;
+    while (i < a.containers_.size() || j < b.containers_.size()) {
+        if (j == b.containers_.size() || (i < a.containers_.size() && a.containers_[i].key < b.containers_[j].key)) {
+            result.containers_.push_back(a.containers_[i++]);
+        } else if (i == a.containers_.size() || b.containers_[j].key < a.containers_[i].key) {
+            result.containers_.push_back(b.containers_[j++]);
+        } else {
+            result.containers_.push_back(unite(a.containers_[i++], b.containers_[j++]));
+        }
+        result.cardinality_ += result.containers_.back().cardinality;
+    }
+    return result;
+}
+
+std::vector<size_t> RoaringBitmap::slots(size_t offset, size_t limit) const {
+    std::vector<size_t> result;
+    for (const Container& container : containers_) {
+        if (result.size() >= limit) {
+            break;
+        }
+
+        // Whole containers before the offset are skipped by cardinality
+        if (offset >= container.cardinality) {
+            offset -= container.cardinality;
+            continue;
+        }
+        append(container, offset, limit, result);
+        offset = 0;
+    }
+    return result;
+}
+
+std::vector<size_t> RoaringBitmap::slotsFrom(size_t first, size_t limit) const {
+    std::vector<size_t> result;
+    if (first > 0xFFFFFFFFu) {
+        return result;
+    }
+
+    uint16_t key = static_cast<uint16_t>(first >> 16);
+    uint16_t low = static_cast<uint16_t>(first & 0xFFFF);
+    for (size_t i = position(key); i < containers_.size() && result.size() < limit; ++i) {
+        const Container& container = containers_[i];
+        size_t begin = 0;
+        if (container.key == key) {
+            // Rank of the first member >= first within this container
+            if (container.dense()) {
+                size_t word = low >> 6;
+                for (size_t w = 0; w < word; ++w) {
+                    begin += popcount64(container.words[w]);
+                }
+                begin += popcount64(container.words[word] & ((uint64_t(1) << (low & 63)) - 1));
+            } else {
+                begin = std::lower_bound(container.array.begin(), container.array.end(), low) -
+                        container.array.begin();
+            }
+        }
+        append(container, begin, limit, result);
+    }
+    return result;
+}
+
+size_t RoaringBitmap::position(uint16_t key) const {
+    return std::lower_bound(containers_.begin(), containers_.end(), key,
+                            [](const Container& container, uint16_t k) { return container.key < k; }) -
+           containers_.begin();
+}
+
+void RoaringBitmap::toBitmap(Container& container) {
+    container.words.assign(CONTAINER_WORDS, 0);
+    for (uint16_t low : container.array) {
+        container.words[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+    container.array.clear();
+    container.array.shrink_to_fit();
+}
+
+void RoaringBitmap::toArray(Container& container) {
+    container.array.clear();
+    container.array.reserve(container.cardinality);
+    for (size_t w = 0; w < CONTAINER_WORDS; ++w) {
+        for (uint64_t bits = container.words[w]; bits; bits &= bits - 1) {
+            container.array.push_back(static_cast<uint16_t>(w * 64 + lowestBit(bits)));
+        }
+    }
+    container.words.clear();
+    container.words.shrink_to_fit();
+}
+
+RoaringBitmap::Container RoaringBitmap::intersect(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+
+    if (a.dense() && b.dense()) {
+        // Count first so a sparse result goes straight into an array
+        for (size_t w = 0; w < CONTAINER_WORDS; ++w) {
+            result.cardinality += static_cast<uint32_t>(popcount64(a.words[w] & b.words[w]));
+        }
+        if (result.cardinality <= ARRAY_MAX) {
+            result.array.reserve(result.cardinality);
+            for (size_t w = 0; w < CONTAINER_WORDS; ++w) {
+                for (uint64_t bits = a.words[w] & b.words[w]; bits; bits &= bits - 1) {
+                    result.array.push_back(static_cast<uint16_t>(w * 64 + lowestBit(bits)));
+                }
+            }
+        } else {
+            result.words.resize(CONTAINER_WORDS);
+            for (size_t w = 0; w < CONTAINER_WORDS; ++w) {
+                result.words[w] = a.words[w] & b.words[w];
+            }
+        }
+    } else if (a.dense() || b.dense()) {
+        // Probe the bitmap with each array value
+        const Container& sparse = a.dense() ? b : a;
+        const Container& bitmap = a.dense() ? a : b;
+        for (uint16_t low : sparse.array) {
+            if ((bitmap.words[low >> 6] >> (low & 63)) & 1) {
+                result.array.push_back(low);
+            }
+        }
+        result.cardinality = static_cast<uint32_t>(result.array.size());
+    } else {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(result.array));
+        result.cardinality = static_cast<uint32_t>(result.array.size());
+    }
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::unite(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+
+    if (a.dense() || b.dense()) {
+        result.words = a.dense() ? a.words : b.words;
+        const Container& other = a.dense() ? b : a;
+        if (other.dense()) {
+            for (size_t w = 0; w < CONTAINER_WORDS; ++w) {
+                result.words[w] |= other.words[w];
+            }
+        } else {
+            for (uint16_t low : other.array) {
+                result.words[low >> 6] |= uint64_t(1) << (low & 63);
+            }
+        }
+        for (uint64_t word : result.words) {
+            result.cardinality += static_cast<uint32_t>(popcount64(word));
+        }
+    } else {
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(result.array));
+        result.cardinality = static_cast<uint32_t>(result.array.size());
+        if (result.array.size() > ARRAY_MAX) {
+            toBitmap(result);
+        }
+    }
+    return result;
+}
+
+void RoaringBitmap::append(const Container& container, size_t begin, size_t limit, std::vector<size_t>& out) {
+    size_t high = static_cast<size_t>(container.key) << 16;
+    if (!container.dense()) {
+        for (size_t i = begin; i < container.array.size() && out.size() < limit; ++i) {
+            out.push_back(high | container.array[i]);
+        }
+        return;
+    }
+
+    size_t skipped = 0;
+    for (size_t w = 0; w < CONTAINER_WORDS && out.size() < limit; ++w) {
+        uint64_t bits = container.words[w];
+        size_t present = popcount64(bits);
+        if (skipped + present <= begin) {
+            skipped += present;
+            continue;
+        }
+        for (; bits && out.size() < limit; bits &= bits - 1) {
+            if (skipped < begin) {
+                skipped++;
+                continue;
+            }
+            out.push_back(high | (w * 64 + lowestBit(bits)));
+        }
+    }
+}
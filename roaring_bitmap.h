@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Compressed set of slots in the style of Roaring bitmaps. Slots are split
+// by their high 16 bits into containers of up to 65536 values; a sparse
+// container is a sorted array of the low 16 bits and a dense one is a
+// 65536-bit bitmap, so memory follows the number of members rather than
+// the largest slot. Cardinality is kept per container and overall, which
+// makes counts O(1) and lets paging skip whole containers.
+class RoaringBitmap {
+public:
+    RoaringBitmap();
+
+    void add(uint32_t value);
+    void remove(uint32_t value);
+    bool contains(uint32_t value) const;
+    void clear();
+    size_t cardinality() const { return cardinality_; }
+    bool empty() const { return cardinality_ == 0; }
+
+    static RoaringBitmap intersect(const RoaringBitmap& a, const RoaringBitmap& b);
+    static RoaringBitmap unite(const RoaringBitmap& a, const RoaringBitmap& b);
+
+    // Members [offset, offset + limit) in increasing order
+    std::vector<size_t> slots(size_t offset, size_t limit) const;
+    // Up to limit members that are >= first, in increasing order
+    std::vector<size_t> slotsFrom(size_t first, size_t limit) const;
+
+private:
+    struct Container {
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> array;   // sorted low bits while sparse
+        std::vector<uint64_t> words;   // 1024 words once dense
+
+        bool dense() const { return !words.empty(); }
+    };
+
+    std::vector<Container> containers_;   // sorted by key
+    size_t cardinality_;
+
+    size_t position(uint16_t key) const;
+    static void toBitmap(Container& container);
+    static void toArray(Container& container);
+    static Container intersect(const Container& a, const Container& b);
+    static Container unite(const Container& a, const Container& b);
+    static void append(const Container& container, size_t begin, size_t limit, std::vector<size_t>& out);
+};
@@ -0,0 +1,262 @@
+// Self-checks for structures whose invariants break silently. Each is
+// driven with seeded random input and compared against a naive reference.
+// Built and run by `make check`; exits non-zero when any check fails.
+#include "quantile_sketch.h"
+#include "roaring_bitmap.h"
+#include "fuzzy_index.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+    // Rank error QuantileSketch promises for K = 200, as a fraction of n
+    const double SKETCH_RANK_ERROR = 0.02;
+
+    // Values one bitmap container holds, and the most it keeps as an array
+    const uint32_t CONTAINER_SIZE = 65536;
+    const size_t CONTAINER_ARRAY_MAX = 4096;
+
+    // Longest pattern the bit-parallel edit distance keeps in one word
+    const size_t PATTERN_WORD_BITS = 64;
+
+    // One seed for the whole suite, so any failure reproduces exactly
+    std::mt19937_64 random(7);
+    size_t failures = 0;
+
+    size_t below(size_t bound) {
+        return static_cast<size_t>(random() % bound);
+    }
+
+    void expect(bool condition, const std::string& what) {
+        if (!condition) {
+            std::cerr << "  " << what << std::endl;
+            failures++;
+        }
+    }
+
+    template <typename T>
+    void expectEqual(const T& actual, const T& expected, const std::string& what) {
+        expect(actual == expected, what + ": got " + std::to_string(actual) +
+                                   ", expected " + std::to_string(expected));
+    }
+
+    // Distance of an estimate's rank range from q * n, as a fraction of n
+    double rankError(const std::vector<double>& sorted, double estimate, double q) {
+        double n = static_cast<double>(sorted.size());
+        double low = std::lower_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin();
+        double high = std::upper_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin();
+        double target = q * n;
+        if (target < low) return (low - target) / n;
+        if (target > high) return (target - high) / n;
+        return 0.0;
+    }
+
+    // Salary columns fed directly and as two merged halves; groups below K
+    // are kept whole and must be exact
+    void checkQuantileSketch() {
+        std::lognormal_distribution<double> salaries(11.0, 0.5);
+        const size_t sizes[] = {1, 150, QuantileSketch::K, 20000, 300000};
+        const double quantiles[] = {0.0, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 1.0};
+
+        for (size_t n : sizes) {
+            for (int merged = 0; merged < 2; ++merged) {
+                std::vector<double> values(n);
+                for (double& value : values) {
+                    value = std::floor(salaries(random));
+                }
+
+                QuantileSketch sketch;
+                QuantileSketch other;
+                for (size_t i = 0; i < n; ++i) {
+                    (merged && i % 2 ? other : sketch).add(values[i]);
+                }
+                sketch.merge(other);
+                std::sort(values.begin(), values.end());
+
+                std::string label = "n=" + std::to_string(n) + (merged ? " merged" : "");
+                expectEqual(sketch.count(), n, label + " count");
+                double allowed = n < QuantileSketch::K ? 0.0 : SKETCH_RANK_ERROR;
+                for (double q : quantiles) {
+                    double error = rankError(values, sketch.quantile(q), q);
+                    expect(error <= allowed, label + " q=" + std::to_string(q) +
+                                             " rank error " + std::to_string(error));
+                }
+            }
+        }
+    }
+
+    bool sameMembers(const RoaringBitmap& bitmap, const std::set<uint32_t>& reference) {
+        std::vector<size_t> members = bitmap.slots(0, std::numeric_limits<size_t>::max());
+        return bitmap.cardinality() == reference.size() &&
+               std::equal(members.begin(), members.end(), reference.begin(), reference.end());
+    }
+
+    // Applies a random add or remove to both the bitmap and the reference
+    void edit(RoaringBitmap& bitmap, std::set<uint32_t>& reference, uint32_t range, size_t removeOneIn) {
+        uint32_t value = static_cast<uint32_t>(below(range));
+        if (below(removeOneIn) == 0) {
+            bitmap.remove(value);
+            reference.erase(value);
+        } else {
+            bitmap.add(value);
+            reference.insert(value);
+        }
+    }
+
+    // Random edits, paging and set operations, then one container pushed
+    // across the array limit and back, checked on both sides of each
+    // conversion
+    void checkRoaringBitmap() {
+        for (int round = 0; round < 40; ++round) {
+            uint32_t range = round % 2 ? 300000 : 20000;
+            int edits = (round % 4) * 30000 + 500;
+            RoaringBitmap a, b;
+            std::set<uint32_t> referenceA, referenceB;
+            for (int i = 0; i < edits; ++i) {
+                edit(a, referenceA, range, 5);
+                edit(b, referenceB, range, 3);
+            }
+
+            std::string label = "round " + std::to_string(round);
+            expect(sameMembers(a, referenceA), label + " members");
+            for (int i = 0; i < 1000; ++i) {
+                uint32_t value = static_cast<uint32_t>(below(range));
+                expect(a.contains(value) == (referenceA.count(value) > 0), label + " contains");
+            }
+
+            size_t offset = below(referenceA.size() + 1);
+            std::vector<size_t> expected;
+            for (auto it = std::next(referenceA.begin(), offset); it != referenceA.end() && expected.size() < 37; ++it) {
+                expected.push_back(*it);
+            }
+            expect(a.slots(offset, 37) == expected, label + " slots page");
+
+            uint32_t first = static_cast<uint32_t>(below(range));
+            expected.clear();
+            for (auto it = referenceA.lower_bound(first); it != referenceA.end() && expected.size() < 50; ++it) {
+                expected.push_back(*it);
+            }
+            expect(a.slotsFrom(first, 50) == expected, label + " slotsFrom");
+
+            std::set<uint32_t> both, either;
+            std::set_intersection(referenceA.begin(), referenceA.end(), referenceB.begin(), referenceB.end(),
+                                  std::inserter(both, both.end()));
+            std::set_union(referenceA.begin(), referenceA.end(), referenceB.begin(), referenceB.end(),
+                           std::inserter(either, either.end()));
+            expect(sameMembers(RoaringBitmap::intersect(a, b), both), label + " intersect");
+            expect(sameMembers(RoaringBitmap::unite(a, b), either), label + " unite");
+        }
+
+        auto checkpoint = [](size_t size) {
+            return size % 500 == 0 || size == CONTAINER_ARRAY_MAX || size == CONTAINER_ARRAY_MAX + 1;
+        };
+        RoaringBitmap bitmap;
+        std::set<uint32_t> reference;
+        while (reference.size() < CONTAINER_ARRAY_MAX + 1000) {
+            uint32_t value = CONTAINER_SIZE + static_cast<uint32_t>(below(CONTAINER_SIZE));
+            bitmap.add(value);
+            reference.insert(value);
+            if (checkpoint(reference.size())) {
+                expect(sameMembers(bitmap, reference), "growing at " + std::to_string(reference.size()));
+            }
+        }
+        while (reference.size() > 100) {
+            uint32_t value = *std::next(reference.begin(), below(reference.size()));
+            bitmap.remove(value);
+            reference.erase(value);
+            if (checkpoint(reference.size())) {
+                expect(sameMembers(bitmap, reference), "draining at " + std::to_string(reference.size()));
+            }
+        }
+
+        // Two sparse halves whose union no longer fits an array, and two
+        // dense ones whose intersection does
+        RoaringBitmap evens, odds, low, high;
+        std::set<uint32_t> all, overlap;
+        for (uint32_t value = 0; value < 3000 * 2; ++value) {
+            (value % 2 ? odds : evens).add(value);
+            all.insert(value);
+        }
+        for (uint32_t value = 0; value < 10000; ++value) {
+            low.add(value);
+            high.add(value + 9900);
+            if (value >= 9900) {
+                overlap.insert(value);
+            }
+        }
+        expect(sameMembers(RoaringBitmap::unite(evens, odds), all), "array union into a bitmap");
+        expect(sameMembers(RoaringBitmap::intersect(low, high), overlap), "bitmap intersection into an array");
+    }
+
+    // Textbook O(|a| * |b|) dynamic-programming Levenshtein distance
+    int naiveDistance(const std::string& a, const std::string& b) {
+        std::vector<int> previous(b.size() + 1), current(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); ++j) {
+            previous[j] = static_cast<int>(j);
+        }
+        for (size_t i = 1; i <= a.size(); ++i) {
+            current[0] = static_cast<int>(i);
+            for (size_t j = 1; j <= b.size(); ++j) {
+                current[j] = std::min({previous[j] + 1, current[j - 1] + 1,
+                                       previous[j - 1] + (a[i - 1] != b[j - 1] ? 1 : 0)});
+            }
+            previous.swap(current);
+        }
+        return previous[b.size()];
+    }
+
+    // Word pairs over a small alphabet, so long common runs are likely.
+    // Lengths cover the empty word, the full 64-bit pattern and the DP
+    // fallback beyond it; bytes above 0x7f catch a signed pattern index.
+    void checkFuzzyDistance() {
+        const char alphabet[] = {'a', 'b', 'c', 'd', static_cast<char>(0xe9)};
+        auto word = [&alphabet](size_t maxLength) {
+            std::string text(below(maxLength + 1), ' ');
+            for (char& c : text) {
+                c = alphabet[below(sizeof(alphabet))];
+            }
+            return text;
+        };
+
+        for (int round = 0; round < 100000; ++round) {
+            size_t maxLength = round % 10 == 0 ? PATTERN_WORD_BITS + 16 : 12;
+            std::string a = round % 1000 == 0 ? std::string(PATTERN_WORD_BITS, 'a') : word(maxLength);
+            std::string b = word(maxLength);
+            expectEqual(FuzzyIndex::distance(a, b), naiveDistance(a, b), "\"" + a + "\" to \"" + b + "\"");
+        }
+    }
+
+    struct Check {
+        const char* name;
+        void (*run)();
+    };
+
+    const Check CHECKS[] = {
+        {"quantile sketch against exact ranks", checkQuantileSketch},
+        {"roaring bitmap against std::set", checkRoaringBitmap},
+        {"edit distance against DP Levenshtein", checkFuzzyDistance},
+    };
+}
+
+int main() {
+    size_t failed = 0;
+    for (const Check& check : CHECKS) {
+        size_t before = failures;
+        check.run();
+        bool passed = failures == before;
+        std::cout << (passed ? "ok    " : "FAIL  ") << check.name << std::endl;
+        failed += passed ? 0 : 1;
+    }
+
+    if (failed > 0) {
+        std::cerr << failed << " of " << std::size(CHECKS) << " self-checks failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -8,6 +8,9 @@
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -20,6 +23,12 @@
 #include <unistd.h>
 #endif
 
+// A peer that hangs up mid-response must fail the send, not raise SIGPIPE
+// and kill the process; macOS has SO_NOSIGPIPE instead, set per socket
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 namespace httplib {
 
 struct Request {
@@ -34,16 +43,30 @@ struct Request {
         return it != params.end() ? it->second : "";
     }
     
+    bool has_param(const std::string& key) const {
+        return params.find(key) != params.end();
+    }
+    
     std::string get_header_value(const std::string& key) const {
         auto it = headers.find(key);
         return it != headers.end() ? it->second : "";
     }
 };
 
+// Receives response data from a content provider; each write is sent to
+// the client as one HTTP chunk
+struct DataSink {
+    std::function<bool(const char* data, size_t length)> write;
+    std::function<void()> done;
+};
+
+using ContentProviderWithoutLength = std::function<bool(size_t offset, DataSink& sink)>;
+
 struct Response {
     int status = 200;
     std::map<std::string, std::string> headers;
     std::string body;
+    ContentProviderWithoutLength content_provider;
     
     void set_content(const std::string& content, const std::string& content_type) {
         body = content;
@@ -54,11 +77,27 @@ struct Response {
     void set_header(const std::string& key, const std::string& value) {
         headers[key] = value;
     }
+    
+    // Streams the body with chunked transfer encoding. The provider is called
+    // until it calls sink.done() or returns false.
+    void set_chunked_content_provider(const std::string& content_type, ContentProviderWithoutLength provider) {
+        body.clear();
+        headers.erase("Content-Length");
+        headers["Content-Type"] = content_type;
+        headers["Transfer-Encoding"] = "chunked";
+        content_provider = std::move(provider);
+    }
 };
 
+// Streams a request body to the receiver as it arrives off the socket.
+// The receiver returns false to stop reading early.
+using ContentReceiver = std::function<bool(const char* data, size_t length)>;
+using ContentReader = std::function<bool(ContentReceiver receiver)>;
+
 class Server {
 public:
     using Handler = std::function<void(const Request&, Response&)>;
+    using HandlerWithContentReader = std::function<void(const Request&, Response&, const ContentReader&)>;
     
     Server() {
 #ifdef _WIN32
@@ -83,6 +122,12 @@ public:
         return *this;
     }
     
+    // The body is not buffered into Request::body; read it through the ContentReader
+    Server& Post(const std::string& pattern, HandlerWithContentReader handler) {
+        reader_routes_["POST:" + pattern] = handler;
+        return *this;
+    }
+    
     Server& Put(const std::string& pattern, Handler handler) {
         routes_["PUT:" + pattern] = handler;
         return *this;
@@ -127,6 +172,9 @@ public:
                 continue;
             }
             
+#ifdef SO_NOSIGPIPE
+            setsockopt(new_socket, SOL_SOCKET, SO_NOSIGPIPE, (char*)&opt, sizeof(opt));
+#endif
             std::thread([this, new_socket]() {
                 handle_request(new_socket);
             }).detach();
@@ -137,22 +185,93 @@ public:
     
 private:
     std::map<std::string, Handler> routes_;
+    std::map<std::string, HandlerWithContentReader> reader_routes_;
+    
+    static const size_t MAX_HEADER_SIZE = 64 * 1024;
+    // Largest body buffered into Request::body; streaming routes are not limited
+    static const size_t MAX_BODY_SIZE = 32 * 1024 * 1024;
     
     void handle_request(int socket) {
-        char buffer[4096] = {0};
-        recv(socket, buffer, 4096, 0);
+        // Read until the end of the headers; anything after them is the
+        // start of the body
+        std::string raw;
+        size_t header_end = std::string::npos;
+        char buffer[4096];
+        
+        while (header_end == std::string::npos && raw.size() < MAX_HEADER_SIZE) {
+            int received = recv(socket, buffer, sizeof(buffer), 0);
+            if (received <= 0) break;
+            raw.append(buffer, received);
+            header_end = raw.find("\r\n\r\n");
+        }
         
-        Request req = parse_request(buffer);
+        std::string body_start;
+        if (header_end != std::string::npos) {
+            body_start = raw.substr(header_end + 4);
+            raw.resize(header_end + 2);
+        }
+        
+        Request req = parse_request(raw);
         Response res;
         
+        size_t content_length = 0;
+        for (const auto& header : req.headers) {
+            if (equals_ignore_case(header.first, "Content-Length")) {
+                content_length = static_cast<size_t>(std::strtoull(header.second.c_str(), nullptr, 10));
+            }
+        }
+        size_t body_remaining = content_length > body_start.size() ? content_length - body_start.size() : 0;
+        
+        ContentReader content_reader = [&](ContentReceiver receiver) {
+            if (!body_start.empty()) {
+                std::string chunk;
+                chunk.swap(body_start);
+                if (!receiver(chunk.data(), chunk.size())) return false;
+            }
+            while (body_remaining > 0) {
+                int received = recv(socket, buffer, std::min(sizeof(buffer), body_remaining), 0);
+                if (received <= 0) return false;
+                body_remaining -= received;
+                if (!receiver(buffer, received)) return false;
+            }
+            return true;
+        };
+        
+        std::string reader_key = req.method + ":" + req.path;
+        HandlerWithContentReader reader_handler;
+        if (reader_routes_.count(reader_key)) {
+            reader_handler = reader_routes_[reader_key];
+        } else {
+            for (const auto& route : reader_routes_) {
+                if (route.first.substr(0, req.method.length() + 1) == req.method + ":" &&
+                    match_route(route.first.substr(req.method.length() + 1), req.path, req)) {
+                    reader_handler = route.second;
+                    break;
+                }
+            }
+        }
+        
+        bool too_large = !reader_handler && content_length > MAX_BODY_SIZE;
+        if (!reader_handler && !too_large) {
+            content_reader([&req](const char* data, size_t length) {
+                req.body.append(data, length);
+                return true;
+            });
+        }
+        
         // Add CORS headers
         res.set_header("Access-Control-Allow-Origin", "*");
         res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
         res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
         
-        if (req.method == "OPTIONS") {
+        if (too_large) {
+            res.status = 413;
+            res.set_content("Payload Too Large", "text/plain");
+        } else if (req.method == "OPTIONS") {
             res.status = 200;
             res.set_content("", "text/plain");
+        } else if (reader_handler) {
+            reader_handler(req, res, content_reader);
         } else {
             std::string route_key = req.method + ":" + req.path;
             auto it = routes_.find(route_key);
@@ -222,15 +341,6 @@ private:
             }
         }
         
-        // Parse body
-        std::string body_line;
-        while (std::getline(stream, body_line)) {
-            req.body += body_line + "\n";
-        }
-        if (!req.body.empty()) {
-            req.body.pop_back(); // Remove last newline
-        }
-        
         return req;
     }
     
@@ -248,6 +358,16 @@ private:
         }
     }
     
+    static bool equals_ignore_case(const std::string& a, const std::string& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
     bool match_route(const std::string& pattern, const std::string& path, Request& req) {
         if (pattern.find(':') == std::string::npos) {
             return pattern == path;
@@ -312,10 +432,55 @@ private:
             response_stream << header.first << ": " << header.second << "\r\n";
         }
         
-        response_stream << "\r\n" << res.body;
+        response_stream << "\r\n";
+        if (!res.content_provider) {
+            response_stream << res.body;
+        }
         
         std::string response = response_stream.str();
-        send(socket, response.c_str(), response.length(), 0);
+        if (!send_all(socket, response.data(), response.length())) {
+            return;
+        }
+        
+        if (res.content_provider) {
+            send_chunked(socket, res.content_provider);
+        }
+    }
+    
+    static bool send_all(int socket, const char* data, size_t length) {
+        while (length > 0) {
+            int sent = send(socket, data, static_cast<int>(length), MSG_NOSIGNAL);
+            if (sent <= 0) return false;
+            data += sent;
+            length -= sent;
+        }
+        return true;
+    }
+    
+    void send_chunked(int socket, const ContentProviderWithoutLength& provider) {
+        bool finished = false;
+        bool ok = true;
+        size_t offset = 0;
+        
+        DataSink sink;
+        sink.write = [&](const char* data, size_t length) {
+            if (length == 0) return ok;
+            std::ostringstream size_line;
+            size_line << std::hex << length << "\r\n";
+            std::string prefix = size_line.str();
+            ok = ok && send_all(socket, prefix.data(), prefix.size()) &&
+                 send_all(socket, data, length) && send_all(socket, "\r\n", 2);
+            offset += length;
+            return ok;
+        };
+        sink.done = [&finished]() { finished = true; };
+        
+        while (ok && !finished && provider(offset, sink)) {
+        }
+        
+        if (ok) {
+            send_all(socket, "0\r\n\r\n", 5);
+        }
     }
 };
 
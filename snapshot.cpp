@@ -0,0 +1,222 @@
+#include "snapshot.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char SNAPSHOT_MAGIC[8] = {'E', 'M', 'S', 'S', 'N', 'A', 'P', '\0'};
+    
+    static_assert(sizeof(BinarySnapshot::SnapshotHeader) == 32, "snapshot header layout changed");
+    static_assert(sizeof(BinarySnapshot::SnapshotRecord) == 80, "snapshot record layout changed");
+    
+    const std::string* stringField(const Employee& emp, int field) {
+        switch (field) {
+            case BinarySnapshot::FIRST_NAME: return &emp.firstName;
+            case BinarySnapshot::LAST_NAME: return &emp.lastName;
+            case BinarySnapshot::EMAIL: return &emp.email;
+            case BinarySnapshot::PHONE: return &emp.phone;
+            case BinarySnapshot::DEPARTMENT: return &emp.department;
+            case BinarySnapshot::POSITION: return &emp.position;
+            case BinarySnapshot::HIRE_DATE: return &emp.hireDate;
+            default: return &emp.profilePhoto;
+        }
+    }
+}
+
+bool BinarySnapshot::open(const std::string& filepath) {
+    close();
+    
+    if (!file_.open(filepath)) {
+        return false;
+    }
+    
+    SnapshotHeader header;
+    if (file_.size() < sizeof(header)) {
+        std::cerr << "Snapshot too small: " << filepath << std::endl;
+        close();
+        return false;
+    }
+    std::memcpy(&header, file_.data(), sizeof(header));
+    
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        header.version != VERSION || header.recordSize != sizeof(SnapshotRecord)) {
+        std::cerr << "Unsupported snapshot format: " << filepath << std::endl;
+        close();
+        return false;
+    }
+    
+    uint64_t tableSize = header.count * sizeof(SnapshotRecord);
+    if (sizeof(header) + tableSize + header.heapSize != file_.size()) {
+        std::cerr << "Truncated snapshot: " << filepath << std::endl;
+        close();
+        return false;
+    }
+    
+    records_ = reinterpret_cast<const SnapshotRecord*>(file_.data() + sizeof(header));
+    heap_ = file_.data() + sizeof(header) + tableSize;
+    count_ = static_cast<size_t>(header.count);
+    heapSize_ = static_cast<size_t>(header.heapSize);
+    return true;
+}
+
+void BinarySnapshot::close() {
+    file_.close();
+    records_ = nullptr;
+    heap_ = nullptr;
+    count_ = 0;
+    heapSize_ = 0;
+}
+
+std::string BinarySnapshot::field(size_t index, StringField field) const {
+    const StringRef& ref = records_[index].fields[field];
+    if (static_cast<size_t>(ref.offset) + ref.length > heapSize_) {
+        return "";
+    }
+    return std::string(heap_ + ref.offset, ref.length);
+}
+
+Employee BinarySnapshot::employee(size_t index) const {
+    const SnapshotRecord& rec = records_[index];
+    
+    Employee emp;
+    emp.id = rec.id;
+    emp.active = rec.active != 0;
+    emp.salary = rec.salary;
+    emp.firstName = field(index, FIRST_NAME);
+    emp.lastName = field(index, LAST_NAME);
+    emp.email = field(index, EMAIL);
+    emp.phone = field(index, PHONE);
+    emp.department = field(index, DEPARTMENT);
+    emp.position = field(index, POSITION);
+    emp.hireDate = field(index, HIRE_DATE);
+    emp.profilePhoto = field(index, PROFILE_PHOTO);
+    return emp;
+}
+
+std::vector<Employee> BinarySnapshot::employees() const {
+    std::vector<Employee> result(count_);
+    
+    size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, count_ / 4096 + 1);
+    size_t chunk = (count_ + threadCount - 1) / threadCount;
+    
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threadCount; ++t) {
+        size_t begin = t * chunk;
+        size_t end = std::min(count_, begin + chunk);
+        workers.emplace_back([this, &result, begin, end] {
+            for (size_t i = begin; i < end; ++i) {
+                result[i] = employee(i);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    return result;
+}
+
+bool BinarySnapshot::Writer::open(const std::string& filepath, size_t count) {
+    filepath_ = filepath;
+    expected_ = count;
+    records_.clear();
+    records_.reserve(count);
+    interned_.clear();
+    heapSize_ = 0;
+    
+    // The heap is written from the end of the record table onward; the
+    // header and records fill the gap in finish()
+    file_.open(filepath, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        return false;
+    }
+    file_.seekp(static_cast<std::streamoff>(sizeof(SnapshotHeader) + count * sizeof(SnapshotRecord)));
+    return file_.good();
+}
+
+void BinarySnapshot::Writer::add(const Employee& emp) {
+    records_.emplace_back();
+    SnapshotRecord& rec = records_.back();
+    std::memset(&rec, 0, sizeof(rec));
+    rec.id = emp.id;
+    rec.active = emp.active ? 1 : 0;
+    rec.salary = emp.salary;
+    
+    // Department and position values are interned, so every record holding
+    // one points at the copy written by the first
+    for (int f = 0; f < STRING_FIELD_COUNT; ++f) {
+        const std::string* value = stringField(emp, f);
+        rec.fields[f].length = static_cast<uint32_t>(value->size());
+        
+        if (f == DEPARTMENT || f == POSITION) {
+            auto it = interned_.find(*value);
+            if (it != interned_.end()) {
+                rec.fields[f].offset = it->second;
+                continue;
+            }
+            interned_.emplace(*value, static_cast<uint32_t>(heapSize_));
+        }
+        rec.fields[f].offset = static_cast<uint32_t>(heapSize_);
+        file_.write(value->data(), static_cast<std::streamsize>(value->size()));
+        heapSize_ += value->size();
+    }
+}
+
+bool BinarySnapshot::Writer::finish() {
+    if (records_.size() != expected_) {
+        std::cerr << "Snapshot expected " << expected_ << " records, got " << records_.size() << std::endl;
+        return false;
+    }
+    if (heapSize_ > UINT32_MAX) {
+        std::cerr << "Snapshot string heap exceeds 4 GB" << std::endl;
+        return false;
+    }
+    
+    SnapshotHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = VERSION;
+    header.recordSize = sizeof(SnapshotRecord);
+    header.count = records_.size();
+    header.heapSize = heapSize_;
+    
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file_.write(reinterpret_cast<const char*>(records_.data()),
+                static_cast<std::streamsize>(records_.size() * sizeof(SnapshotRecord)));
+    file_.close();
+    return !file_.fail() && syncPath(filepath_);
+}
+
+bool BinarySnapshot::syncPath(const std::string& path) {
+#ifdef _WIN32
+    // Directory entries cannot be flushed on Windows; renames are journaled
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        DWORD attributes = GetFileAttributesA(path.c_str());
+        return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+    }
+    bool synced = FlushFileBuffers(handle) != 0;
+    CloseHandle(handle);
+    return synced;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#endif
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "employee.h"
+#include "mapped_file.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+
+// Versioned binary snapshot of the employee table. Layout (little-endian):
+//
+//   SnapshotHeader
+//   SnapshotRecord[count]   fixed-width, one per employee
+//   string heap             UTF-8 bytes referenced by (offset, length) pairs
+//
+// The file is memory-mapped on load, so records can be read in place
+// without tokenizing any text. JSON remains the import/export format.
+//
+// Database does not serve from the mapping: it materializes every record
+// and rebuilds all of its indexes before the first request, so restart
+// time still grows with the table and is dominated by the index build.
+class BinarySnapshot {
+public:
+    static const uint32_t VERSION = 1;
+    
+    struct StringRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+    
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t count;
+        uint64_t heapSize;
+    };
+    
+    enum StringField {
+        FIRST_NAME, LAST_NAME, EMAIL, PHONE, DEPARTMENT,
+        POSITION, HIRE_DATE, PROFILE_PHOTO, STRING_FIELD_COUNT
+    };
+    
+    struct SnapshotRecord {
+        int32_t id;
+        uint8_t active;
+        uint8_t reserved[3];
+        double salary;
+        StringRef fields[STRING_FIELD_COUNT];
+    };
+    
+    // Maps and validates filepath; records stay readable until close()
+    bool open(const std::string& filepath);
+    void close();
+    
+    size_t size() const { return count_; }
+    const SnapshotRecord& record(size_t index) const { return records_[index]; }
+    std::string field(size_t index, StringField field) const;
+    Employee employee(size_t index) const;
+    
+    // Materializes every record, splitting the work across threads
+    std::vector<Employee> employees() const;
+    
+    // Writes a snapshot as employees arrive, so callers need not hold the
+    // whole table: strings go straight to the heap, and only the fixed-width
+    // records wait in memory for finish() to write them ahead of it
+    class Writer {
+    public:
+        // Leaves room for count records, which must all be added
+        bool open(const std::string& filepath, size_t count);
+        void add(const Employee& employee);
+        // Writes the header and records, then fsyncs the file; callers
+        // rename it into place
+        bool finish();
+        
+    private:
+        std::ofstream file_;
+        std::string filepath_;
+        std::vector<SnapshotRecord> records_;
+        std::unordered_map<std::string, uint32_t> interned_; // department/position -> heap offset
+        uint64_t heapSize_ = 0;
+        size_t expected_ = 0;
+    };
+    
+    // Flushes a file, or a directory's entries, to stable storage
+    static bool syncPath(const std::string& path);
+    
+private:
+    MappedFile file_;
+    const SnapshotRecord* records_ = nullptr;
+    const char* heap_ = nullptr;
+    size_t count_ = 0;
+    size_t heapSize_ = 0;
+};
@@ -0,0 +1,136 @@
+#include "sort_index.h"
+#include <algorithm>
+
+namespace {
+    // Merge the delta and tombstones into the base once they reach this size
+    const size_t MIN_MERGE_SIZE = 1024;
+
+    template <typename T>
+    int compare(const T& a, const T& b) {
+        return a < b ? -1 : (b < a ? 1 : 0);
+    }
+}
+
+SortIndex::SortIndex(const std::vector<Employee>* table, Key key)
+    : table_(table), key_(key), built_(false), delta_(SlotLess{table, key}) {
+}
+
+void SortIndex::build() {
+    base_.clear();
+    delta_.clear();
+    removed_.clear();
+
+    const std::vector<Employee>& table = *table_;
+    for (size_t slot = 0; slot < table.size(); ++slot) {
+        if (table[slot].active) {
+            base_.push_back(static_cast<uint32_t>(slot));
+        }
+    }
+    std::sort(base_.begin(), base_.end(), SlotLess{table_, key_});
+    built_ = true;
+}
+
+void SortIndex::reset() {
+    base_.clear();
+    base_.shrink_to_fit();
+    delta_.clear();
+    removed_.clear();
+    built_ = false;
+}
+
+void SortIndex::add(size_t slot) {
+    if (!built_) {
+        return;
+    }
+    delta_.insert(static_cast<uint32_t>(slot));
+    maybeMerge();
+}
+
+void SortIndex::remove(size_t slot) {
+    if (!built_) {
+        return;
+    }
+
+    // Found by the current values, which the caller has not changed yet
+    if (delta_.erase(static_cast<uint32_t>(slot)) == 0) {
+        removed_.insert(static_cast<uint32_t>(slot));
+        maybeMerge();
+    }
+}
+
+void SortIndex::scan(bool descending, const std::function<bool(size_t)>& visit) const {
+    SlotLess slotLess{table_, key_};
+
+    // Merge the base and the delta, skipping tombstoned base entries
+    auto merge = [&](auto baseIt, auto baseEnd, auto deltaIt, auto deltaEnd, auto before) {
+        while (baseIt != baseEnd || deltaIt != deltaEnd) {
+            if (baseIt != baseEnd && removed_.count(*baseIt)) {
+                ++baseIt;
+                continue;
+            }
+
+            uint32_t slot;
+            if (deltaIt == deltaEnd || (baseIt != baseEnd && before(*baseIt, *deltaIt))) {
+                slot = *baseIt++;
+            } else {
+                slot = *deltaIt++;
+            }
+            if (!visit(slot)) {
+                return;
+            }
+        }
+    };
+
+    if (descending) {
+        merge(base_.rbegin(), base_.rend(), delta_.rbegin(), delta_.rend(),
+              [&](uint32_t a, uint32_t b) { return slotLess(b, a); });
+    } else {
+        merge(base_.begin(), base_.end(), delta_.begin(), delta_.end(), slotLess);
+    }
+}
+
+bool SortIndex::parseKey(const std::string& name, Key& key) {
+    static const char* const names[KEY_COUNT] = {
+        "id", "firstName", "lastName", "email", "department", "position", "salary", "hireDate"
+    };
+    for (int i = 0; i < KEY_COUNT; ++i) {
+        if (name == names[i]) {
+            key = static_cast<Key>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SortIndex::less(const Employee& a, const Employee& b, Key key) {
+    int order = 0;
+    switch (key) {
+        case ID:         break;
+        case FIRST_NAME: order = a.firstName.compare(b.firstName); break;
+        case LAST_NAME:  order = a.lastName.compare(b.lastName); break;
+        case EMAIL:      order = a.email.compare(b.email); break;
+        case DEPARTMENT: order = a.department.compare(b.department); break;
+        case POSITION:   order = a.position.compare(b.position); break;
+        case SALARY:     order = compare(a.salary, b.salary); break;
+        case HIRE_DATE:  order = a.hireDate.compare(b.hireDate); break;
+        default:         break;
+    }
+    return order != 0 ? order < 0 : a.id < b.id;
+}
+
+void SortIndex::maybeMerge() {
+    if (delta_.size() + removed_.size() < std::max(MIN_MERGE_SIZE, base_.size() / 8)) {
+        return;
+    }
+
+    std::vector<uint32_t> merged;
+    merged.reserve(base_.size() + delta_.size());
+    scan(false, [&merged](size_t slot) {
+        merged.push_back(static_cast<uint32_t>(slot));
+        return true;
+    });
+
+    base_.swap(merged);
+    delta_.clear();
+    removed_.clear();
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "employee.h"
+#include <string>
+#include <vector>
+#include <set>
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+
+// Sorted permutation of the active slots by one column, used to serve
+// ORDER BY without touching the table's own order. The index is built
+// lazily on first use. After that it is maintained like SalaryIndex:
+// a sorted base array, an ordered delta of newly added slots, and
+// tombstones for base slots that were removed or changed; the pieces are
+// merged once the delta and tombstones reach an eighth of the base.
+// Ties are broken by id so the order is total.
+class SortIndex {
+public:
+    enum Key {
+        ID,
+        FIRST_NAME,
+        LAST_NAME,
+        EMAIL,
+        DEPARTMENT,
+        POSITION,
+        SALARY,
+        HIRE_DATE,
+        KEY_COUNT
+    };
+
+    SortIndex(const std::vector<Employee>* table, Key key);
+
+    bool built() const { return built_; }
+    void build();
+    void reset();
+
+    // No-ops until the index has been built; remove must see the old values
+    void add(size_t slot);
+    void remove(size_t slot);
+
+    // Visits slots in order until visit returns false
+    void scan(bool descending, const std::function<bool(size_t)>& visit) const;
+
+    static bool parseKey(const std::string& name, Key& key);
+    static bool less(const Employee& a, const Employee& b, Key key);
+
+private:
+    struct SlotLess {
+        const std::vector<Employee>* table;
+        Key key;
+        bool operator()(uint32_t a, uint32_t b) const { return less((*table)[a], (*table)[b], key); }
+    };
+
+    const std::vector<Employee>* table_;
+    Key key_;
+    bool built_;
+    std::vector<uint32_t> base_;
+    std::set<uint32_t, SlotLess> delta_;
+    std::unordered_set<uint32_t> removed_;
+
+    void maybeMerge();
+};
+
+// Requested result order; by default results keep their natural order
+struct OrderBy {
+    bool enabled = false;
+    SortIndex::Key key = SortIndex::ID;
+    bool descending = false;
+};
@@ -0,0 +1,322 @@
+#include "text_index.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+    const size_t GRAM_LENGTH = 3;
+
+    // Separates the indexed fields inside a slot's text; never part of a trigram
+    const char FIELD_SEPARATOR = '\x1f';
+
+    // Relevance weight of a match in firstName, lastName, email, department, position
+    const int FIELD_WEIGHTS[] = {8, 8, 4, 2, 2};
+    const size_t FIELD_COUNT = sizeof(FIELD_WEIGHTS) / sizeof(FIELD_WEIGHTS[0]);
+
+    // Rebuild the postings once stale entries outnumber half of the live ones
+    const size_t MIN_STALE_FOR_REBUILD = 1 << 16;
+
+    uint32_t packGram(const char* p) {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(p[2]));
+    }
+
+    std::string lower(const std::string& value) {
+        std::string result(value);
+        for (char& c : result) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return result;
+    }
+}
+
+TextIndex::TextIndex() : entries_(0), stale_(0), built_(false) {
+}
+
+void TextIndex::build(const std::vector<Employee>& table) {
+    clear();
+    built_ = true;
+    texts_.reserve(table.size());
+    for (size_t slot = 0; slot < table.size(); ++slot) {
+        if (table[slot].active) {
+            add(slot, table[slot]);
+        }
+    }
+}
+
+void TextIndex::add(size_t slot, const Employee& employee) {
+    if (!built_) {
+        return;
+    }
+
+    std::string text = lower(employee.firstName);
+    text += FIELD_SEPARATOR;
+    text += lower(employee.lastName);
+    text += FIELD_SEPARATOR;
+    text += lower(employee.email);
+    text += FIELD_SEPARATOR;
+    text += lower(employee.department);
+    text += FIELD_SEPARATOR;
+    text += lower(employee.position);
+
+    if (slot >= texts_.size()) {
+        texts_.resize(slot + 1);
+    }
+    indexText(static_cast<uint32_t>(slot), text);
+    texts_[slot].swap(text);
+}
+
+void TextIndex::remove(size_t slot) {
+    if (slot >= texts_.size() || texts_[slot].empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> grams;
+    collectGrams(texts_[slot], grams);
+    stale_ += grams.size();
+    texts_[slot].clear();
+
+    if (stale_ >= MIN_STALE_FOR_REBUILD && stale_ * 2 > entries_) {
+        rebuild();
+    }
+}
+
+void TextIndex::clear() {
+    texts_.clear();
+    postings_.clear();
+    entries_ = 0;
+    stale_ = 0;
+    built_ = false;
+}
+
+std::string TextIndex::normalize(const std::string& query) {
+    return lower(query);
+}
+
+size_t TextIndex::estimate(const std::string& needle) const {
+    if (needle.size() < GRAM_LENGTH) {
+        return texts_.size();
+    }
+
+    std::vector<uint32_t> grams;
+    collectGrams(needle, grams);
+
+    size_t smallest = texts_.size();
+    for (uint32_t gram : grams) {
+        auto it = postings_.find(gram);
+        smallest = std::min(smallest, it != postings_.end() ? it->second.size() : 0);
+    }
+    return smallest;
+}
+
+int TextIndex::relevance(size_t slot, const std::string& needle) const {
+    return slot < texts_.size() && !texts_[slot].empty() ? score(texts_[slot], needle) : 0;
+}
+
+void TextIndex::hits(const std::string& needle, std::vector<std::pair<int, uint32_t>>& out) const {
+    if (needle.empty()) {
+        return;
+    }
+
+    auto verify = [&](uint32_t slot) {
+        int value = score(texts_[slot], needle);
+        if (value > 0) {
+            out.emplace_back(value, slot);
+        }
+    };
+
+    if (needle.size() < GRAM_LENGTH) {
+        // Too short to have a trigram; scan the compact lowercased texts
+        for (size_t slot = 0; slot < texts_.size(); ++slot) {
+            if (!texts_[slot].empty()) {
+                verify(static_cast<uint32_t>(slot));
+            }
+        }
+    } else {
+        std::vector<uint32_t> grams;
+        collectGrams(needle, grams);
+
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (uint32_t gram : grams) {
+            auto it = postings_.find(gram);
+            if (it == postings_.end()) {
+                return;
+            }
+            lists.push_back(&it->second);
+        }
+        std::sort(lists.begin(), lists.end(),
+                  [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) {
+                      return a->size() < b->size();
+                  });
+
+        // Walk the rarest trigram and probe the others by binary search
+        std::vector<uint32_t> candidates(*lists[0]);
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+            const std::vector<uint32_t>& list = *lists[i];
+            auto from = list.begin();
+            size_t kept = 0;
+            for (uint32_t slot : candidates) {
+                from = std::lower_bound(from, list.end(), slot);
+                if (from == list.end()) break;
+                if (*from == slot) candidates[kept++] = slot;
+            }
+            candidates.resize(kept);
+        }
+
+        for (uint32_t slot : candidates) {
+            verify(slot);
+        }
+    }
+}
+
+void TextIndex::indexText(uint32_t slot, const std::string& text) {
+    std::vector<uint32_t> grams;
+    collectGrams(text, grams);
+
+    for (uint32_t gram : grams) {
+        std::vector<uint32_t>& list = postings_[gram];
+        if (list.empty() || list.back() < slot) {
+            list.push_back(slot);
+            entries_++;
+        } else {
+            // Re-added slots may still be listed from before a lazy removal
+            auto pos = std::lower_bound(list.begin(), list.end(), slot);
+            if (pos == list.end() || *pos != slot) {
+                list.insert(pos, slot);
+                entries_++;
+            }
+        }
+    }
+}
+
+void TextIndex::rebuild() {
+    postings_.clear();
+    entries_ = 0;
+    stale_ = 0;
+    for (size_t slot = 0; slot < texts_.size(); ++slot) {
+        if (!texts_[slot].empty()) {
+            indexText(static_cast<uint32_t>(slot), texts_[slot]);
+        }
+    }
+}
+
+int TextIndex::score(const std::string& text, const std::string& needle) const {
+    if (text.find(needle) == std::string::npos) {
+        return 0;
+    }
+
+    // Exact field > field prefix > word prefix > anywhere, weighted by field
+    int total = 0;
+    size_t begin = 0;
+    for (size_t field = 0; field < FIELD_COUNT && begin <= text.size(); ++field) {
+        size_t end = text.find(FIELD_SEPARATOR, begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+
+        size_t pos = text.find(needle, begin);
+        if (pos != std::string::npos && pos + needle.size() <= end) {
+            int kind = 1;
+            if (pos == begin) {
+                kind = pos + needle.size() == end ? 4 : 3;
+            } else if (!std::isalnum(static_cast<unsigned char>(text[pos - 1]))) {
+                kind = 2;
+            }
+            total += FIELD_WEIGHTS[field] * kind;
+        }
+        begin = end + 1;
+    }
+    return total;
+}
+
+void TextIndex::collectGrams(const std::string& text, std::vector<uint32_t>& grams) {
+    grams.clear();
+    for (size_t i = 0; i + GRAM_LENGTH <= text.size(); ++i) {
+        const char* p = text.data() + i;
+        if (p[0] == FIELD_SEPARATOR || p[1] == FIELD_SEPARATOR || p[2] == FIELD_SEPARATOR) {
+            continue;
+        }
+        grams.push_back(packGram(p));
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+void PrefixIndex::build(const std::vector<Employee>& table) {
+    std::vector<Key> sorted;
+    std::vector<std::string> keys;
+    for (size_t slot = 0; slot < table.size(); ++slot) {
+        if (!table[slot].active) {
+            continue;
+        }
+        collectKeys(table[slot], keys);
+        for (std::string& key : keys) {
+            sorted.emplace_back(std::move(key), static_cast<uint32_t>(slot));
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    // Inserting at end() with every key in order is constant time per key
+    keys_.clear();
+    for (Key& key : sorted) {
+        keys_.emplace_hint(keys_.end(), std::move(key));
+    }
+    built_ = true;
+}
+
+void PrefixIndex::add(size_t slot, const Employee& employee) {
+    if (!built_) {
+        return;
+    }
+
+    std::vector<std::string> keys;
+    collectKeys(employee, keys);
+    for (std::string& key : keys) {
+        keys_.emplace(std::move(key), static_cast<uint32_t>(slot));
+    }
+}
+
+void PrefixIndex::remove(size_t slot, const Employee& employee) {
+    if (!built_) {
+        return;
+    }
+
+    std::vector<std::string> keys;
+    collectKeys(employee, keys);
+    for (std::string& key : keys) {
+        keys_.erase(Key(std::move(key), static_cast<uint32_t>(slot)));
+    }
+}
+
+std::vector<size_t> PrefixIndex::lookup(const std::string& prefix, size_t limit) const {
+    std::vector<size_t> slots;
+    std::string needle = lower(prefix);
+    if (needle.empty()) {
+        return slots;
+    }
+
+    for (auto it = keys_.lower_bound(Key(needle, 0));
+         it != keys_.end() && slots.size() < limit && it->first.compare(0, needle.size(), needle) == 0;
+         ++it) {
+        // One employee can match through several keys
+        if (std::find(slots.begin(), slots.end(), it->second) == slots.end()) {
+            slots.push_back(it->second);
+        }
+    }
+    return slots;
+}
+
+void PrefixIndex::collectKeys(const Employee& employee, std::vector<std::string>& keys) {
+    keys.clear();
+    std::string first = lower(employee.firstName);
+    std::string last = lower(employee.lastName);
+    std::string email = lower(employee.email);
+
+    if (!first.empty()) keys.push_back(first);
+    if (!last.empty()) keys.push_back(last);
+    if (!first.empty() && !last.empty()) keys.push_back(first + " " + last);
+    if (!email.empty()) keys.push_back(email);
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "employee.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <set>
+#include <utility>
+
+// Case-insensitive substring index over the searchable employee fields
+// (firstName, lastName, email, department, position). Each active slot
+// keeps a lowercased copy of those fields, and every trigram that occurs in
+// them maps to the sorted slots containing it. A query intersects the
+// postings of its own trigrams and verifies the survivors against the
+// stored text, so only plausible rows are ever touched.
+//
+// Removals are lazy: postings keep stale slots until verification rejects
+// them, and the postings are rebuilt once stale entries pile up.
+//
+// Like FuzzyIndex, it is built on first use and maintained after that, so
+// a restart does not wait for it.
+class TextIndex {
+public:
+    TextIndex();
+
+    bool built() const { return built_; }
+    void build(const std::vector<Employee>& table);
+    // No-ops until the index has been built
+    void add(size_t slot, const Employee& employee);
+    void remove(size_t slot);
+    void clear();
+
+    // Case-folds a query the way the index stores text
+    static std::string normalize(const std::string& query);
+
+    // Upper bound on the matches of a normalized needle, from posting sizes
+    size_t estimate(const std::string& needle) const;
+    // (relevance, slot) for every active slot containing a normalized needle
+    void hits(const std::string& needle, std::vector<std::pair<int, uint32_t>>& out) const;
+    // Relevance of one slot for a normalized needle; 0 when it does not match
+    int relevance(size_t slot, const std::string& needle) const;
+
+private:
+    std::vector<std::string> texts_;   // lowercased fields per slot, "" when inactive
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;
+    size_t entries_;
+    size_t stale_;
+    bool built_;
+
+    void indexText(uint32_t slot, const std::string& text);
+    void rebuild();
+    int score(const std::string& text, const std::string& needle) const;
+
+    static void collectGrams(const std::string& text, std::vector<uint32_t>& grams);
+};
+
+// Ordered index of lowercased first names, last names, full names and emails
+// for autocomplete. A prefix lookup is one lower_bound followed by a walk
+// over the keys that share the prefix, so it stays proportional to the
+// number of suggestions rather than the table size. Built on first use,
+// like TextIndex.
+class PrefixIndex {
+public:
+    bool built() const { return built_; }
+    // Sorts every key once and fills the set from the sorted run
+    void build(const std::vector<Employee>& table);
+    // No-ops until the index has been built
+    void add(size_t slot, const Employee& employee);
+    void remove(size_t slot, const Employee& employee);
+    void clear() { keys_.clear(); built_ = false; }
+
+    // Up to limit distinct slots whose keys start with prefix, in key order
+    std::vector<size_t> lookup(const std::string& prefix, size_t limit) const;
+
+private:
+    typedef std::pair<std::string, uint32_t> Key;
+    std::set<Key> keys_;
+    bool built_ = false;
+
+    static void collectKeys(const Employee& employee, std::vector<std::string>& keys);
+};
@@ -0,0 +1,397 @@
+#include "wal.h"
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    // Appends refuse larger payloads, so replay can treat a larger length
+    // field as corruption
+    const uint32_t MAX_RECORD_SIZE = 16 * 1024 * 1024;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& filepath, DurabilityMode mode,
+                             std::chrono::milliseconds commitWindow)
+    : filepath_(filepath), file_(nullptr), size_(0), mode_(mode), commitWindow_(commitWindow),
+      lastTicket_(0), durableTicket_(0), broken_(false), stopping_(false), goodSize_(0) {
+    flusherThread_ = std::thread(&WriteAheadLog::flusherLoop, this);
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    flushCv_.notify_one();
+    if (flusherThread_.joinable()) {
+        flusherThread_.join();
+    }
+    close();
+}
+
+bool WriteAheadLog::open() {
+    std::lock_guard<std::mutex> io(ioMutex_);
+    if (file_) {
+        return true;
+    }
+    
+    if (!openFile("ab")) {
+        return false;
+    }
+
+    std::error_code ec;
+    size_t existing = static_cast<size_t>(std::filesystem::file_size(filepath_, ec));
+    goodSize_ = ec ? 0 : existing;
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_ = goodSize_ + pending_.size();
+    return true;
+}
+
+void WriteAheadLog::close() {
+    std::lock_guard<std::mutex> io(ioMutex_);
+    writePending();
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+uint64_t WriteAheadLog::append(Operation op, const Employee& employee) {
+    std::string payload(1, static_cast<char>(op));
+    if (op == REMOVE) {
+        payload += std::to_string(employee.id);
+    } else {
+        payload += employee.toJson();
+    }
+    if (payload.size() > MAX_RECORD_SIZE) {
+        std::cerr << "WAL record of " << payload.size() << " bytes exceeds " << MAX_RECORD_SIZE << std::endl;
+        return 0;
+    }
+
+    std::string frame;
+    frame.reserve(payload.size() + 8);
+    writeU32(frame, static_cast<uint32_t>(payload.size()));
+    writeU32(frame, crc32(payload.data(), payload.size()));
+    frame += payload;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (broken_) {
+        return 0;
+    }
+    bool wasEmpty = pending_.empty();
+    pending_ += frame;
+    size_ += frame.size();
+    uint64_t ticket = ++lastTicket_;
+    if (wasEmpty) {
+        flushCv_.notify_one();
+    }
+    return ticket;
+}
+
+bool WriteAheadLog::waitForCommit(uint64_t ticket) {
+    return waitForCommit(ticket, ticket);
+}
+
+bool WriteAheadLog::waitForCommit(uint64_t first, uint64_t last) {
+    if (first == 0 || last < first) {
+        return false;
+    }
+    if (mode_ != SYNC) {
+        return true;
+    }
+
+    // The flusher may have split the range across several batches, so any
+    // failed batch overlapping it fails the whole range
+    std::unique_lock<std::mutex> lock(mutex_);
+    commitCv_.wait(lock, [this, last] { return durableTicket_ >= last; });
+    // The failed ranges are sorted and disjoint; only the first one ending
+    // at or after first can overlap
+    auto failed = std::lower_bound(failedTickets_.begin(), failedTickets_.end(), first,
+                                   [](const std::pair<uint64_t, uint64_t>& range, uint64_t ticket) {
+                                       return range.second < ticket;
+                                   });
+    return failed == failedTickets_.end() || failed->first > last;
+}
+
+bool WriteAheadLog::flush() {
+    std::lock_guard<std::mutex> io(ioMutex_);
+    return writePending();
+}
+
+bool WriteAheadLog::rotate(const std::string& archivePath) {
+    std::lock_guard<std::mutex> io(ioMutex_);
+    
+    // Everything appended so far belongs to the archived segment
+    writePending();
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(filepath_, archivePath, ec);
+    if (ec) {
+        std::cerr << "Failed to rotate write-ahead log: " << ec.message() << std::endl;
+        openFile("ab");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_ = pending_.size();
+    goodSize_ = 0;
+    return openFile("ab");
+}
+
+bool WriteAheadLog::reset() {
+    std::lock_guard<std::mutex> io(ioMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.clear();
+        size_ = 0;
+        durableTicket_ = lastTicket_;
+    }
+    commitCv_.notify_all();
+
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    goodSize_ = 0;
+    if (!openFile("wb")) {
+        return false;
+    }
+    
+    // Whatever a failed batch held is in the snapshot now, so its tickets
+    // stop reporting failure
+    std::lock_guard<std::mutex> lock(mutex_);
+    broken_ = false;
+    failedTickets_.clear();
+    return true;
+}
+
+size_t WriteAheadLog::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+bool WriteAheadLog::parseMode(const std::string& name, DurabilityMode& mode) {
+    if (name == "sync") {
+        mode = SYNC;
+    } else if (name == "async") {
+        mode = ASYNC;
+    } else if (name == "none") {
+        mode = NONE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void WriteAheadLog::flusherLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    
+    while (true) {
+        flushCv_.wait(lock, [this] { return !pending_.empty() || stopping_; });
+        if (stopping_) {
+            return; // close() writes whatever is still pending
+        }
+        
+        // Give concurrent writers a chance to join this commit
+        if (commitWindow_.count() > 0) {
+            flushCv_.wait_for(lock, commitWindow_, [this] { return stopping_; });
+        }
+        
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> io(ioMutex_);
+            writePending();
+        }
+        lock.lock();
+    }
+}
+
+bool WriteAheadLog::writePending() {
+    // Caller holds ioMutex_, so batches reach the file in ticket order
+    std::string batch;
+    uint64_t firstTicket;
+    uint64_t lastTicket;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.empty()) {
+            return true;
+        }
+        batch.swap(pending_);
+        firstTicket = durableTicket_ + 1;
+        lastTicket = lastTicket_;
+    }
+
+    bool written = (file_ || openFile("ab")) &&
+                   std::fwrite(batch.data(), 1, batch.size(), file_) == batch.size() &&
+                   std::fflush(file_) == 0 &&
+                   (mode_ == NONE || syncFile());
+
+    if (written) {
+        goodSize_ += batch.size();
+    } else {
+        discardFailedBatch(batch.size());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        durableTicket_ = lastTicket;
+        if (!written) {
+            // Only SYNC waiters look the ranges up. Batches are contiguous,
+            // so a run of failed ones is kept as one range.
+            if (mode_ == SYNC) {
+                if (!failedTickets_.empty() && failedTickets_.back().second + 1 == firstTicket) {
+                    failedTickets_.back().second = lastTicket;
+                } else {
+                    failedTickets_.emplace_back(firstTicket, lastTicket);
+                }
+            }
+            std::cerr << "Failed to commit write-ahead log records " << firstTicket
+                      << "-" << lastTicket << std::endl;
+        }
+    }
+    commitCv_.notify_all();
+    return written;
+}
+
+void WriteAheadLog::discardFailedBatch(size_t batchSize) {
+    // Part of the batch may have reached the file. Replay stops at the first
+    // torn frame, so cut the file back to the last intact one before anything
+    // else is appended; if that fails, refuse appends rather than log records
+    // that could never be replayed.
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    std::error_code ec;
+    std::filesystem::resize_file(filepath_, goodSize_, ec);
+    bool reopened = !ec && openFile("ab");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_ -= std::min(size_, batchSize);
+    if (!reopened) {
+        broken_ = true;
+        std::cerr << "Write-ahead log " << filepath_ << " is damaged; refusing further changes" << std::endl;
+    }
+}
+
+bool WriteAheadLog::openFile(const char* mode) {
+    file_ = std::fopen(filepath_.c_str(), mode);
+    if (!file_) {
+        std::cerr << "Failed to open write-ahead log: " << filepath_ << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool WriteAheadLog::syncFile() {
+#ifdef _WIN32
+    return _commit(_fileno(file_)) == 0;
+#elif defined(__APPLE__)
+    return fsync(fileno(file_)) == 0;
+#else
+    return fdatasync(fileno(file_)) == 0;
+#endif
+}
+
+size_t WriteAheadLog::replay(const std::string& filepath,
+                             const std::function<void(Operation, const Employee&)>& apply) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        return 0;
+    }
+
+    std::string content((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+    file.close();
+
+    size_t offset = 0;
+    size_t applied = 0;
+
+    while (offset + 8 <= content.size()) {
+        const unsigned char* header = reinterpret_cast<const unsigned char*>(content.data() + offset);
+        uint32_t length = readU32(header);
+        uint32_t checksum = readU32(header + 4);
+
+        if (length == 0 || length > MAX_RECORD_SIZE || offset + 8 + length > content.size()) {
+            break; // Torn write at the tail of the log
+        }
+
+        const char* payload = content.data() + offset + 8;
+        if (crc32(payload, length) != checksum) {
+            std::cerr << "Write-ahead log checksum mismatch at offset " << offset << std::endl;
+            break;
+        }
+
+        Operation op = static_cast<Operation>(payload[0]);
+        std::string body(payload + 1, length - 1);
+
+        try {
+            Employee emp;
+            if (op == REMOVE) {
+                emp.id = std::stoi(body);
+            } else if (op == UPSERT) {
+                emp = Employee::fromJson(body);
+            } else {
+                break;
+            }
+            apply(op, emp);
+            applied++;
+        } catch (const std::exception& e) {
+            std::cerr << "Error replaying write-ahead log record: " << body << std::endl;
+        }
+
+        offset += 8 + length;
+    }
+
+    if (offset < content.size()) {
+        std::cerr << "Ignoring " << (content.size() - offset)
+                  << " trailing bytes in write-ahead log " << filepath << std::endl;
+    }
+
+    return applied;
+}
+
+uint32_t WriteAheadLog::crc32(const char* data, size_t length) {
+    static uint32_t table[256];
+    static bool initialized = [] {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)initialized;
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void WriteAheadLog::writeU32(std::string& out, uint32_t value) {
+    out += static_cast<char>(value & 0xFF);
+    out += static_cast<char>((value >> 8) & 0xFF);
+    out += static_cast<char>((value >> 16) & 0xFF);
+    out += static_cast<char>((value >> 24) & 0xFF);
+}
+
+uint32_t WriteAheadLog::readU32(const unsigned char* in) {
+    return static_cast<uint32_t>(in[0]) |
+           (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) |
+           (static_cast<uint32_t>(in[3]) << 24);
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "employee.h"
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+// Append-only log of Database mutations. Every record is framed as
+// [u32 payload length][u32 crc32 of payload][payload], where the payload is
+// one operation byte followed by the employee JSON (upserts) or the id
+// (deletes). Replaying the log on top of the last snapshot restores the
+// state at the time of the last intact record.
+//
+// Appends only buffer the frame and hand back a commit ticket. A dedicated
+// flusher thread group-commits everything buffered with a single write and
+// fdatasync, so many concurrent writers share one disk round trip.
+//
+// A batch that fails to write or sync is cut back off the file, so later
+// batches never land behind a torn frame; its tickets report failure until
+// reset() drops a log whose changes a snapshot now holds. If the file cannot
+// be cut back the log stops accepting appends.
+// The log cannot undo the caller's change: a failed ticket only means the
+// change is not durable yet, and it stays in memory until the next snapshot.
+class WriteAheadLog {
+public:
+    enum Operation : char {
+        UPSERT = 'U',
+        REMOVE = 'D'
+    };
+
+    enum DurabilityMode {
+        SYNC,   // Writers block until their record has been fdatasync'ed
+        ASYNC,  // Writers return immediately; the flusher syncs in the background
+        NONE    // Records are written without fdatasync (benchmarks only)
+    };
+
+    WriteAheadLog(const std::string& filepath, DurabilityMode mode = SYNC,
+                  std::chrono::milliseconds commitWindow = std::chrono::milliseconds(0));
+    ~WriteAheadLog();
+
+    // Log management
+    bool open();
+    void close();
+    // Returns 0 for a record over the size limit, or once the log has
+    // stopped accepting appends
+    uint64_t append(Operation op, const Employee& employee);
+    bool waitForCommit(uint64_t ticket);
+    // True only if every ticket from first to last committed
+    bool waitForCommit(uint64_t first, uint64_t last);
+    bool flush();
+
+    // Moves the current log to archivePath and starts an empty one
+    bool rotate(const std::string& archivePath);
+    // Discards the log; only valid once its records are in a snapshot
+    bool reset();
+
+    // Calls apply for every intact record in filepath, stopping at the first
+    // torn or corrupt frame. Returns the number of records applied.
+    static size_t replay(const std::string& filepath,
+                         const std::function<void(Operation, const Employee&)>& apply);
+
+    size_t size();
+    const std::string& path() const { return filepath_; }
+    DurabilityMode mode() const { return mode_; }
+    // sync, async or none; false for anything else
+    static bool parseMode(const std::string& name, DurabilityMode& mode);
+
+private:
+    std::string filepath_;
+    std::FILE* file_;
+    size_t size_;
+    DurabilityMode mode_;
+    std::chrono::milliseconds commitWindow_;
+
+    // Group commit state; lock ioMutex_ before mutex_ when both are needed
+    std::mutex mutex_;
+    std::mutex ioMutex_;
+    std::condition_variable flushCv_;
+    std::condition_variable commitCv_;
+    std::string pending_;
+    uint64_t lastTicket_;
+    uint64_t durableTicket_;
+    std::vector<std::pair<uint64_t, uint64_t>> failedTickets_;   // failed runs of batches since the last reset, in order
+    bool broken_;             // a failed batch could not be cut back off the file
+    bool stopping_;
+    size_t goodSize_;         // bytes of intact frames in the file; guarded by ioMutex_
+    std::thread flusherThread_;
+
+    void flusherLoop();
+    bool writePending();
+    bool openFile(const char* mode);
+    void discardFailedBatch(size_t batchSize);
+    bool syncFile();
+
+    static uint32_t crc32(const char* data, size_t length);
+    static void writeU32(std::string& out, uint32_t value);
+    static uint32_t readU32(const unsigned char* in);
+};